@@ -17,18 +17,94 @@
 #include "delay.h"
 #if USE_AD5932
 
+#include <string.h>
+
 #include "ad5932.h"
+#include "ad5932_trace.h"
 
 // --------------------------------------------------------------------------------------------------------------------
 // Defines
 // --------------------------------------------------------------------------------------------------------------------
 
+#ifndef AD5932_NOINIT
+	#define AD5932_NOINIT	__attribute__((section(".noinit")))		//not cleared by the startup code
+#endif
+#define AD5932_SHADOW_MAGIC		0x5A5932A6
+#if AD5932_USE_PWM_CTRL
+	#define AD5932_TIM_MR0R			(1UL << 1)		//MCR: reset on MR0 match
+	#define AD5932_TIM_MR1S			(1UL << 5)		//MCR: stop on MR1 match
+	#define AD5932_TIM_EM0			(1UL << 0)		//EMR: level of MATx.0
+	#define AD5932_TIM_EMC0_SET		(1UL << 4)		//EMR: MATx.0 goes high on MR0 match
+	#define AD5932_DMA_CH(n)		((LPC_GPDMACH_TypeDef*)(LPC_GPDMACH0_BASE + (n) * 0x20))
+	#define AD5932_DMA_ENABLE		(1UL << 0)		//DMACCConfig: channel enable
+	#define AD5932_DMA_M2P			(1UL << 11)		//DMACCConfig: memory to peripheral, flow control by the DMA
+	#define AD5932_DMA_WORDS		((2UL << 18) | (2UL << 21))	//DMACCControl: 32 bit source and destination
+	#define AD5932_DMA_SI			(1UL << 26)		//DMACCControl: source increment
+	#define AD5932_DMA_MAT_REQUEST	8				//request line of MAT0.0, MATx.y is 8 + 2 * x + y
+	#define AD5932_PCONP_GPDMA		(1UL << 29)
+#endif
+
+// --------------------------------------------------------------------------------------------------------------------
+// Types
+// --------------------------------------------------------------------------------------------------------------------
+
+//device state kept over a warm reset
+typedef struct
+{
+	u32 magic;
+	u32 mclk;				//nominal MCLK
+	s32 mclkCorrection;		//ppb
+	u16 control;			//last control register word
+	bool standby;
+	u32 triggerTime;		//last CTRL trigger, AD5932_SetTimeBase() time
+	AD5932Sweep_t sweep;
+	u32 checksum;
+} AD5932Shadow_t;
+
 // --------------------------------------------------------------------------------------------------------------------
 // Variables
 // --------------------------------------------------------------------------------------------------------------------
 LPC_SSP_TypeDef* SSPPort;
 u16 ad5932CMD;
 u32 ad5932MCLK;
+u32 ad5932MCLKCal;
+s32 ad5932MCLKCorrection;
+s32 ad5932TempCorrection;
+const s32* ad5932TempTable;
+u16 ad5932TempCount;
+s16 ad5932TempMin;
+u16 ad5932TempStep;
+u16 ad5932TempBucketWidth;
+s32 ad5932TempBucket;
+u64 ad5932FreqFactor;
+u32 ad5932SCLK;
+AD5932_FreqMeter_t ad5932FreqMeter;
+AD5932_TimeBase_t ad5932TimeBase;
+bool ad5932Standby;
+bool ad5932PowerPolicy;
+u08 ad5932SweepScheduled;
+u32 ad5932SweepStart[AD5932_SCHEDULE_DEPTH];		//ordered by start, the running / next window first
+u32 ad5932SweepEnd[AD5932_SCHEDULE_DEPTH];
+u32 ad5932WakeLatency = AD5932_WAKE_LATENCY_DEFAULT;
+AD5932Sweep_t ad5932Sweep;
+u16 ad5932Control;
+AD5932Shadow_t ad5932Shadow AD5932_NOINIT;
+#if defined(AD5932_PIN_MOCK)
+volatile u08 ad5932PinMock;
+void (*ad5932PinMockHook)(void);
+#endif
+u32 ad5932TriggerTime;
+#if AD5932_USE_PWM_CTRL
+LPC_TIM_TypeDef* const ad5932PWMTimers[4] = { LPC_TIM0, LPC_TIM1, LPC_TIM2, LPC_TIM3 };
+u08 ad5932PWMTimer;
+volatile bool ad5932PWMBusy;
+//DMA sources and the linked list items, in RAM
+u32 ad5932PWMDwell;				//fixed dwell time
+u32 ad5932PWMPulseEnd;			//EMR: CTRL low, high again at the next MR0 match
+u32 ad5932PWMStopMCR;			//MCR: stop at the end of the last CTRL pulse
+GPDMA_LLI_Type ad5932PWMStopLLI;
+GPDMA_LLI_Type ad5932PWMPulseLLI;
+#endif
 
 // --------------------------------------------------------------------------------------------------------------------
 // Macros
@@ -55,6 +131,14 @@ u32 ad5932MCLK;
 //-FSYNC needs to be held low while the 16bit is sent out, but high otherwise
 //-Set CTRL pin high only after the last command, for like 100us. (low->high->low)
 //-SPI mode should be CHPA: first clock edge, and CPOL: Low", but the communications is worked at all possible SPI modes in my board. o.O
+//-In EXTERNAL_TRIGGER mode every CTRL rising edge after the first one steps the frequency, TINT is not used.
+// AD5932_StartPWMStepping() generates these edges with the MATx.0 output of a timer, so CTRL has to be routed to it
+// (pin mux is up to you). Two GPDMA channels, requested by the MR0 / MR1 matches, load the next dwell time and end the
+// CTRL pulse, and the timer stops itself after the last step: there is no interrupt and no CPU work per step.
+//-The pins are driven by the AD5932_xxx_SET() / CLR() macros of ad5932.h. They default to the SPARE0..3 macros, but
+// defining AD5932_xxx_PORT / AD5932_xxx_BIT makes each of them a single FIOSET / FIOCLR store, without a call or branch.
+//-SCLK cycle time (t1) is min. 25ns, high/low time (t2, t3) min. 10ns, so SCLK must not exceed 40MHz (AD5932_SCLK_MAX).
+// Long flying wires usually need much less, AD5932_CalibrateSPI() can find the real limit through the MSBOUT loopback.
 
 // --------------------------------------------------------------------------------------------------------------------
 // Functions
@@ -70,6 +154,51 @@ void AD5932_SetSPI(LPC_SSP_TypeDef* SSPx)
 	SSPPort = SSPx;
 }
 
+// ....................................................................................................................
+// @brief:      Configures the used SSP (spi) peripheral: 16 bit SPI master with the given clock mode and rate
+// @param[in]:  LPC_SSP0 or LPC_SSP1
+// @param[in]:  SSP_CPOL_HI / SSP_CPOL_LO - clock polarity
+// @param[in]:  SSP_CPHA_FIRST / SSP_CPHA_SECOND - clock phase
+// @param[in]:  SCLK rate in Hz, capped at AD5932_SCLK_MAX
+// @return:     The SCLK rate requested from the SSP, 0 on error.
+// ....................................................................................................................
+u32 AD5932_ConfigSPI(LPC_SSP_TypeDef* SSPx, u32 CPOL, u32 CPHA, u32 clockRate)
+{
+	SSP_CFG_Type sspCfg;
+
+	if (clockRate == 0)
+		return 0;
+	if (clockRate > AD5932_SCLK_MAX)
+		clockRate = AD5932_SCLK_MAX;
+
+	SSP_ConfigStructInit(&sspCfg);
+	sspCfg.CPHA = CPHA;
+	sspCfg.CPOL = CPOL;
+	sspCfg.ClockRate = clockRate;
+	sspCfg.Databit = SSP_DATABIT_16;
+	sspCfg.Mode = SSP_MASTER_MODE;
+	sspCfg.FrameFormat = SSP_FRAME_SPI;
+
+	SSP_Cmd(SSPx, DISABLE);
+	SSP_Init(SSPx, &sspCfg);
+	SSP_Cmd(SSPx, ENABLE);
+
+	SSPPort = SSPx;
+	ad5932SCLK = clockRate;
+	return clockRate;
+}
+
+// ....................................................................................................................
+// @brief:      Sets the frequency meter used by the calibration and self test routines.
+//				The function has to measure the MSBOUT pin frequency (timer capture, counter etc.) and return it in Hz.
+// @param[in]:  Measurement function, or NULL
+// @return:     none
+// ....................................................................................................................
+void AD5932_SetFreqMeter(AD5932_FreqMeter_t meter)
+{
+	ad5932FreqMeter = meter;
+}
+
 // ....................................................................................................................
 // @brief:      Set / Clear AD5932 FSYNC pin.
 // @param[in]:  none
@@ -78,9 +207,112 @@ void AD5932_SetSPI(LPC_SSP_TypeDef* SSPx)
 void AD5932_SetFSYNCPin(bool state)
 {
 	if (state)
-		SPARE0_on();
+		AD5932_FSYNC_SET();
 	else
-		SPARE0_off();
+		AD5932_FSYNC_CLR();
+}
+
+// ....................................................................................................................
+// @brief:      Checksum of the warm reset shadow, the fields summed and rotated one by one (the padding is left out).
+// @param[in]:  none
+// @return:     Checksum
+// ....................................................................................................................
+static u32 AD5932_ShadowChecksum(void)
+{
+	u32 fields[10];
+	u32 i, sum = 0;
+
+	fields[0] = ad5932Shadow.magic;
+	fields[1] = ad5932Shadow.mclk;
+	fields[2] = (u32)ad5932Shadow.mclkCorrection;
+	fields[3] = ad5932Shadow.control | ((u32)ad5932Shadow.standby << 16);
+	fields[4] = ad5932Shadow.triggerTime;
+	fields[5] = ad5932Shadow.sweep.mclk;
+	fields[6] = ad5932Shadow.sweep.startWord;
+	fields[7] = ad5932Shadow.sweep.deltaWord;
+	fields[8] = ad5932Shadow.sweep.increment | ((u32)ad5932Shadow.sweep.intervall << 16);
+	fields[9] = ad5932Shadow.sweep.incrementBase | ((u32)ad5932Shadow.sweep.sweepType << 8);
+	for (i = 0; i < sizeof(fields) / sizeof(fields[0]); i++)
+		sum = ((sum << 5) | (sum >> 27)) + fields[i];
+	return ~sum;
+}
+
+// ....................................................................................................................
+// @brief:      Copies the device state into the no-init shadow, so a warm reset can resume without reprogramming.
+//				The driver calls it at the end of every command sequence (sweep, single frequency, plan, library
+//				sweep), at CTRL triggers and at MCLK / standby changes. Call it after own sequences of single register
+//				writes (AD5932_SetStartFrequency() and the like), they only update the sweep in RAM.
+// @param[in]:  none
+// @return:     none
+// ....................................................................................................................
+void AD5932_SaveShadow(void)
+{
+	ad5932Shadow.magic = AD5932_SHADOW_MAGIC;
+	ad5932Shadow.mclk = ad5932MCLK;
+	ad5932Shadow.mclkCorrection = ad5932MCLKCorrection;
+	ad5932Shadow.control = ad5932Control;
+	ad5932Shadow.standby = ad5932Standby;
+	ad5932Shadow.triggerTime = ad5932TriggerTime;
+	ad5932Shadow.sweep = ad5932Sweep;
+	ad5932Shadow.checksum = AD5932_ShadowChecksum();
+}
+
+// ....................................................................................................................
+// @brief:      Updates a programmed sweep copy from a command word sent to the chip.
+// @param[in]:  Command word
+// @param[out]: Sweep copy
+// @param[out]: Control register word copy
+// @return:     none
+// ....................................................................................................................
+void AD5932_DecodeCommand(u16 commandWord, AD5932Sweep_t* sweep, u16* control)
+{
+	u16 value = commandWord & 0x0FFF;
+
+	switch (commandWord & 0xF000)
+	{
+		case AD5932_CREG:
+			*control = commandWord;
+			break;
+		case AD5932_NINCR:
+			sweep->increment = value;
+			break;
+		case AD5932_DFREQ_LO:
+			sweep->deltaWord = (sweep->deltaWord & 0x007FF000) | value;
+			break;
+		case AD5932_DFREQ_HI:
+			sweep->deltaWord = (sweep->deltaWord & 0x00000FFF) | ((u32)(value & 0x07FF) << 12);
+			sweep->sweepType = (value & 0x0800) ? DECREMENTAL_SWEEP : INCREMENTAL_SWEEP;
+			break;
+		case AD5932_TINT_WCYCLES:
+		case AD5932_TINT_WCYCLES | 0x1000:
+			sweep->intervall = value & 0x07FF;
+			sweep->incrementBase = WAVE_OUT_BASED;
+			break;
+		case AD5932_TINT_MCLKCYCLES:
+		case AD5932_TINT_MCLKCYCLES | 0x1000:
+			sweep->intervall = value & 0x07FF;
+			sweep->incrementBase = MCLK_INP_BASED;
+			break;
+		case AD5932_FSTART_LO:
+			sweep->startWord = (sweep->startWord & 0x00FFF000) | value;
+			break;
+		case AD5932_FSTART_HI:
+			sweep->startWord = (sweep->startWord & 0x00000FFF) | ((u32)value << 12);
+			break;
+		default:
+			break;
+	}
+}
+
+// ....................................................................................................................
+// @brief:      Keeps the programmed sweep (AD5932_GetSweep()) up to date from the sent command words, in RAM only.
+//				The no-init copy is written once per command sequence by AD5932_SaveShadow().
+// @param[in]:  Command word
+// @return:     none
+// ....................................................................................................................
+static void AD5932_UpdateShadow(u16 commandWord)
+{
+	AD5932_DecodeCommand(commandWord, &ad5932Sweep, &ad5932Control);
 }
 
 // ....................................................................................................................
@@ -95,15 +327,70 @@ s32 AD5932_SendSPICommand(u16 commandWord)
 	ret = SSP_GetTransferStatus(SSPPort);
 	if (ret == SSP_STATUS_CLEAR)
 	{
-		AD5932_SetFSYNCPin(false);
+		//the driver's own chip: the FSYNC edges are plain pin stores, no callback and no branch
+		AD5932_TRACE_EVENT(AD5932_TR_SPI_WORD, AD5932_TR_BEGIN, commandWord);
+		AD5932_FSYNC_CLR();
 		ret = SSP_Transfer(SSPPort, NULL, &commandWord, NULL, 1, SSP_XFER_POLL);
-		AD5932_SetFSYNCPin(true);
+		AD5932_FSYNC_SET();
+		AD5932_TRACE_EVENT(AD5932_TR_SPI_WORD, AD5932_TR_END, commandWord);
 		if (ret > 0)
+		{
+			AD5932_UpdateShadow(commandWord);
 			return 0;
+		}
 		return ret;
 	}
 	else
+	{
+		AD5932_TRACE_EVENT(AD5932_TR_BUS_WAIT, AD5932_TR_INSTANT, commandWord);
 		return AD5932_PORT_BUSY;
+	}
+}
+
+// ....................................................................................................................
+// @brief:      Send out one 16Bit long command to one of several AD5932 chips on the same SSP (spi) bus
+// @param[in]:  Command word
+// @param[in]:  FSYNC control function of the chips
+// @param[in]:  Chip index passed to the FSYNC control
+// @return:     0 if OK. Negative if there was an SPI error, Positive if SPI is busy, 0xFFF0 if there is no FSYNC
+//				control.
+// ....................................................................................................................
+s32 AD5932_SendSPICommandCS(u16 commandWord, AD5932_ChipSelect_t chipSelect, u08 chip)
+{
+	return AD5932_SendSPICommandOn(SSPPort, commandWord, chipSelect, chip);
+}
+
+// ....................................................................................................................
+// @brief:      Send out one 16Bit long command to a chip on any SSP (spi) bus. The programmed sweep of the driver
+//				(AD5932_GetSweep()) is not touched, use AD5932_SendSPICommand() for the driver's own chip.
+// @param[in]:  LPC_SSP0 or LPC_SSP1
+// @param[in]:  Command word
+// @param[in]:  FSYNC control function of the chips, not NULL
+// @param[in]:  Chip index passed to the FSYNC control
+// @return:     0 if OK. Negative if there was an SPI error, Positive if SPI is busy, 0xFFF0 if there is no FSYNC
+//				control.
+// ....................................................................................................................
+s32 AD5932_SendSPICommandOn(LPC_SSP_TypeDef* SSPx, u16 commandWord, AD5932_ChipSelect_t chipSelect, u08 chip)
+{
+	s32 ret;
+
+	if (chipSelect == NULL)
+		return AD5932_PARAM_ERROR;
+
+	//check if port is free
+	ret = SSP_GetTransferStatus(SSPx);
+	if (ret != SSP_STATUS_CLEAR)
+	{
+		AD5932_TRACE_EVENT(AD5932_TR_BUS_WAIT, AD5932_TR_INSTANT, commandWord);
+		return AD5932_PORT_BUSY;
+	}
+
+	AD5932_TRACE_EVENT(AD5932_TR_SPI_WORD, AD5932_TR_BEGIN, commandWord);
+	chipSelect(chip, false);
+	ret = SSP_Transfer(SSPx, NULL, &commandWord, NULL, 1, SSP_XFER_POLL);
+	chipSelect(chip, true);
+	AD5932_TRACE_EVENT(AD5932_TR_SPI_WORD, AD5932_TR_END, commandWord);
+	return (ret > 0) ? 0 : ret;
 }
 
 // ....................................................................................................................
@@ -114,9 +401,15 @@ s32 AD5932_SendSPICommand(u16 commandWord)
 void AD5932_SetCTRLPin(bool state)
 {
 	if (state)
-		SPARE2_on();
+	{
+		AD5932_CTRL_SET();
+		AD5932_TRACE_EVENT(AD5932_TR_CTRL, AD5932_TR_BEGIN, 0);
+	}
 	else
-		SPARE2_off();
+	{
+		AD5932_CTRL_CLR();
+		AD5932_TRACE_EVENT(AD5932_TR_CTRL, AD5932_TR_END, 0);
+	}
 }
 
 // ....................................................................................................................
@@ -127,9 +420,9 @@ void AD5932_SetCTRLPin(bool state)
 void AD5932_SetINTPin(bool state)
 {
 	if (state)
-		SPARE3_on();
+		AD5932_INT_SET();
 	else
-		SPARE3_off();
+		AD5932_INT_CLR();
 }
 
 // ....................................................................................................................
@@ -140,9 +433,9 @@ void AD5932_SetINTPin(bool state)
 void AD5932_SetSTDBYPin(bool state)
 {
 	if (state)
-		SPARE1_on();
+		AD5932_STDBY_SET();
 	else
-		SPARE1_off();
+		AD5932_STDBY_CLR();
 }
 
 // ....................................................................................................................
@@ -152,11 +445,98 @@ void AD5932_SetSTDBYPin(bool state)
 // ....................................................................................................................
 void AD5932_Init(u32 MCLK)
 {
-	AD5932_SetCTRLPin(false);
-	AD5932_SetINTPin(false);
-	AD5932_SetFSYNCPin(true);
-	AD5932_SetSTDBYPin(false);
+	AD5932_CTRL_CLR();
+	AD5932_INT_CLR();
+	AD5932_FSYNC_SET();
+	AD5932_STDBY_CLR();
+	ad5932Standby = false;
+	ad5932Control = 0;
+	memset(&ad5932Sweep, 0, sizeof(ad5932Sweep));
+	ad5932MCLK = MCLK;
+	AD5932_SetMCLKCorrection(0);
+}
+
+// ....................................................................................................................
+// @brief:      AD5932_Init() for watchdog / soft resets. If the no-init shadow is valid and was made with the same MCLK,
+//				the chip kept running through the reset: only the pins are set up again (CTRL and INTERRUPT are not
+//				pulsed, STANDBY is restored) and the driver state (programmed sweep, trigger time, MCLK correction) is taken back,
+//				so there is no reset / reprogram sequence. Falls back to AD5932_Init() otherwise.
+// @param[in]:  External MCLK frequency in HZ
+// @return:     true if the state was resumed, false after a cold init.
+// ....................................................................................................................
+bool AD5932_WarmInit(u32 MCLK)
+{
+	if ((ad5932Shadow.magic != AD5932_SHADOW_MAGIC) || (ad5932Shadow.checksum != AD5932_ShadowChecksum()) || (ad5932Shadow.mclk != MCLK))
+	{
+		AD5932_Init(MCLK);
+		return false;
+	}
+
+	AD5932_CTRL_CLR();
+	AD5932_INT_CLR();
+	AD5932_FSYNC_SET();
+	AD5932_SetSTDBYPin(ad5932Shadow.standby);
+	ad5932Standby = ad5932Shadow.standby;
+	ad5932Control = ad5932Shadow.control;
+	ad5932Sweep = ad5932Shadow.sweep;
+	ad5932TriggerTime = ad5932Shadow.triggerTime;
 	ad5932MCLK = MCLK;
+	AD5932_SetMCLKCorrection(ad5932Shadow.mclkCorrection);
+	return true;
+}
+
+static void AD5932_UpdateMCLK(void);
+
+// ....................................................................................................................
+// @brief:      Sets the MCLK frequency error. The corrected MCLK is folded into the fixed-point frequency -> tuning word
+//				factor, so every later FSTART / DFREQ word is corrected without any extra cost.
+// @param[in]:  MCLK error in ppb (1000 = 1ppm), positive if the real MCLK is faster than the nominal
+// @return:     none
+// ....................................................................................................................
+void AD5932_SetMCLKCorrection(s32 ppb)
+{
+	ad5932MCLKCorrection = ppb;
+	AD5932_UpdateMCLK();
+}
+
+// ....................................................................................................................
+// @brief:      Recalculates the corrected MCLK and the tuning word factor from the calibration and temperature errors.
+// @param[in]:  none
+// @return:     none
+// ....................................................................................................................
+static void AD5932_UpdateMCLK(void)
+{
+	s64 ppb = (s64)ad5932MCLKCorrection + ad5932TempCorrection;
+
+	ad5932MCLKCal = (u32)((s64)ad5932MCLK + ((s64)ad5932MCLK * ppb) / 1000000000);
+	if (ad5932MCLKCal == 0)
+		ad5932MCLKCal = 1;
+
+	//2^56 / MCLK: the 24 bit accumulator resolution and 32 fractional bits
+	ad5932FreqFactor = ((u64)AD5932_ACCU_RESOLUTION << 32) / ad5932MCLKCal;
+	ad5932Sweep.mclk = ad5932MCLKCal;
+	AD5932_SaveShadow();
+}
+
+// ....................................................................................................................
+// @brief:      Converts a frequency to a tuning word with the corrected MCLK (See AN-1044)
+// @param[in]:  Frequency in Hz
+// @return:     Tuning word (frequency * 2^24 / MCLK), truncated like the original division, so an uncorrected MCLK
+//				gives the same words as before. Saturated to 0xFFFFFF at or above MCLK.
+// ....................................................................................................................
+u32 AD5932_FrequencyToWord(u32 value)
+{
+	return AD5932_FactorToWord(value, ad5932FreqFactor, ad5932MCLKCal);
+}
+
+// ....................................................................................................................
+// @brief:      Converts a tuning word to a frequency with the corrected MCLK
+// @param[in]:  Tuning word
+// @return:     Frequency in Hz
+// ....................................................................................................................
+u32 AD5932_WordToFrequency(u32 word)
+{
+	return ((u64)word * ad5932MCLKCal) >> 24;
 }
 
 // ....................................................................................................................
@@ -219,7 +599,7 @@ s32 AD5932_SetIncrementIntervall(u16 value, AD5932_IncIntervall_t incrementBase)
 	if (incrementBase == WAVE_OUT_BASED)
 		ad5932CMD = AD5932_TINT_WCYCLES | value;
 	else
-		ad5932CMD = MCLK_INP_BASED | value;
+		ad5932CMD = AD5932_TINT_MCLKCYCLES | value;
 
 	return AD5932_SendSPICommand(ad5932CMD);
 }
@@ -236,7 +616,7 @@ s32 AD5932_SetDeltaFrequency(u32 value, AD5932_SweepType_t SweepType)
 		return AD5932_PARAM_ERROR;
 
 	//We have to calculate the right command based on the MCLK frequency, the desired start frequency and the on-chip accumulator resolution (See AN-1044)
-	u32 tmp = (u64)value * AD5932_ACCU_RESOLUTION / ad5932MCLK;
+	u32 tmp = AD5932_FrequencyToWord(value);
 
 	ad5932CMD = AD5932_DFREQ_LO | (tmp & 0x00000FFF);
 	ret = AD5932_SendSPICommand(ad5932CMD);
@@ -261,19 +641,30 @@ s32 AD5932_SetDeltaFrequency(u32 value, AD5932_SweepType_t SweepType)
 // ....................................................................................................................
 s32 AD5932_SetStartFrequency(u32 value)
 {
-	s32 ret;
 	if ((value > 0x7FFFFFFF) || (value < 1))
 		return AD5932_PARAM_ERROR;
 
 	//We have to calculate the right command based on the MCLK frequency, the desired start frequency and the on-chip accumulator resolution (See AN-1044)
-	u32 tmp = (u64)value * AD5932_ACCU_RESOLUTION / ad5932MCLK;
+	u32 tmp = AD5932_FrequencyToWord(value);
 
-	ad5932CMD = AD5932_FSTART_LO | (tmp & 0x00000FFF);
+	return AD5932_SetStartFrequencyWord(tmp);
+}
+
+// ....................................................................................................................
+// @brief:      Set the start frequency with a raw 24 bit tuning word.
+// @param[in]:  Tuning word (frequency * 2^24 / MCLK)
+// @return:     Return 0 if all is OK. Negative if error, 0xFFFF if SPI port is busy.
+// ....................................................................................................................
+s32 AD5932_SetStartFrequencyWord(u32 word)
+{
+	s32 ret;
+
+	ad5932CMD = AD5932_FSTART_LO | (word & 0x00000FFF);
 	ret = AD5932_SendSPICommand(ad5932CMD);
 	if (ret == AD5932_PORT_BUSY)
 		return ret;
 
-	ad5932CMD = AD5932_FSTART_HI | ((tmp >> 12) & 0x00000FFF);
+	ad5932CMD = AD5932_FSTART_HI | ((word >> 12) & 0x00000FFF);
 	ret = AD5932_SendSPICommand(ad5932CMD);
 	if (ret == AD5932_PORT_BUSY)
 		return ret;
@@ -288,9 +679,14 @@ s32 AD5932_SetStartFrequency(u32 value)
 // ....................................................................................................................
 void AD5932_TriggerCTRLPin(void)
 {
-	AD5932_SetCTRLPin(true);
+	if (ad5932TimeBase != NULL)
+		ad5932TriggerTime = ad5932TimeBase();
+	AD5932_CTRL_SET();
+	AD5932_TRACE_EVENT(AD5932_TR_CTRL, AD5932_TR_BEGIN, 0);
 	delay_us(100);
-	AD5932_SetCTRLPin(false);
+	AD5932_CTRL_CLR();
+	AD5932_TRACE_EVENT(AD5932_TR_CTRL, AD5932_TR_END, 0);
+	AD5932_SaveShadow();
 }
 
 // ....................................................................................................................
@@ -300,9 +696,9 @@ void AD5932_TriggerCTRLPin(void)
 // ....................................................................................................................
 void AD5932_TriggerINTPin(void)
 {
-	AD5932_SetINTPin(true);
+	AD5932_INT_SET();
 	delay_us(100);
-	AD5932_SetINTPin(false);
+	AD5932_INT_CLR();
 }
 
 // ....................................................................................................................
@@ -314,7 +710,7 @@ void AD5932_TriggerINTPin(void)
 s32 AD5932_SingleFrequencyGenerator(u32 frequency, RegBits_t WAVE_TYPE, RegBits_t MSBOUT, RegBits_t TRIGGER)
 {
 	s32 ret;
-	AD5932_SetCTRLPin(false);
+	AD5932_CTRL_CLR();
 
 	ret = AD5932_SetControlRegister(DAC_EN, WAVE_TYPE, MSBOUT, EXTERNAL_TRIGGER, SYNCSEL_END, SYNCOUT_EN);
 	if (ret < 0)
@@ -324,8 +720,54 @@ s32 AD5932_SingleFrequencyGenerator(u32 frequency, RegBits_t WAVE_TYPE, RegBits_
 	if (ret < 0)
 		return -2;
 
+	//the trigger saves the shadow too
+	if (TRIGGER == AUTOMATIC_TRIGGER)
+		AD5932_TriggerCTRLPin();
+	else
+		AD5932_SaveShadow();
+	return 0;
+}
+
+// ....................................................................................................................
+// @brief:      Validates and programs a sweep, see AD5932_SweepGenerator()
+// ....................................................................................................................
+static s32 AD5932_SweepProgram(u32 startFreq, u32 deltaFrerq, u32 increment, AD5932_IncIntervall_t INCRTYPE, u32 incIntervall, RegBits_t SWEEPTYPE, RegBits_t WAVE_TYPE, RegBits_t MSBOUT, RegBits_t TRIGGER, RegBits_t SYNCSEL, RegBits_t SYNCOUT)
+{
+	s32 ret;
+
+	AD5932_TRACE_EVENT(AD5932_TR_VALIDATE, AD5932_TR_BEGIN, 0);
+	ret = AD5932_ValidateSweep(startFreq, deltaFrerq, &increment, (AD5932_SweepType_t)SWEEPTYPE, false);
+	AD5932_TRACE_EVENT(AD5932_TR_VALIDATE, AD5932_TR_END, 0);
+	if (ret != 0)
+		return -6;
+
+	AD5932_CTRL_CLR();
+
+	ret = AD5932_SetControlRegister(DAC_EN, WAVE_TYPE, MSBOUT, TRIGGER, SYNCSEL, SYNCOUT);
+	if (ret < 0)
+		return -1;
+
+	ret = AD5932_SetStartFrequency(startFreq);
+	if (ret < 0)
+		return -2;
+
+	ret = AD5932_SetDeltaFrequency(deltaFrerq, (AD5932_SweepType_t)SWEEPTYPE);
+	if (ret < 0)
+		return -3;
+
+	ret = AD5932_SetIncrementIntervall(incIntervall, INCRTYPE);
+	if (ret < 0)
+		return -4;
+
+	ret = AD5932_SetIncrement(increment);
+	if (ret < 0)
+		return -5;
+
+	//the trigger saves the shadow too
 	if (TRIGGER == AUTOMATIC_TRIGGER)
 		AD5932_TriggerCTRLPin();
+	else
+		AD5932_SaveShadow();
 	return 0;
 }
 
@@ -356,36 +798,69 @@ s32 AD5932_SingleFrequencyGenerator(u32 frequency, RegBits_t WAVE_TYPE, RegBits_
 // @param[in]:  Syncout,
 //				SYNCOUT_EN: the SYNC output is available at the SYNCOUT pin.
 //				SYNCOUT_DISABLE: the SYNCOP pin is disabled (three-state).
-// @return:     0 if all is OK, negative value if not.
+// @return:     0 if all is OK, negative value if not. -6 if the scan would pass MCLK/2 or wrap (see AD5932_ValidateSweep()).
 // ....................................................................................................................
 s32 AD5932_SweepGenerator(u32 startFreq, u32 deltaFrerq, u32 increment, AD5932_IncIntervall_t INCRTYPE, u32 incIntervall, RegBits_t SWEEPTYPE, RegBits_t WAVE_TYPE, RegBits_t MSBOUT, RegBits_t TRIGGER, RegBits_t SYNCSEL, RegBits_t SYNCOUT)
 {
 	s32 ret;
-	AD5932_SetCTRLPin(false);
 
-	ret = AD5932_SetControlRegister(DAC_EN, WAVE_TYPE, MSBOUT, TRIGGER, SYNCSEL, SYNCOUT);
-	if (ret < 0)
-		return -1;
+	AD5932_TRACE_EVENT(AD5932_TR_SWEEP, AD5932_TR_BEGIN, 0);
+	ret = AD5932_SweepProgram(startFreq, deltaFrerq, increment, INCRTYPE, incIntervall, SWEEPTYPE, WAVE_TYPE, MSBOUT, TRIGGER, SYNCSEL, SYNCOUT);
+	AD5932_TRACE_EVENT(AD5932_TR_SWEEP, AD5932_TR_END, (u16)ret);
+	return ret;
+}
 
-	ret = AD5932_SetStartFrequency(startFreq);
-	if (ret < 0)
-		return -2;
+// ....................................................................................................................
+// @brief:      Checks the whole scan envelope before anything is sent: the start, delta and end tuning words must stay
+//				below MCLK/2 (Nyquist), the delta must fit the 23 bit DFREQ field, and a decremental scan must not wrap
+//				through zero. Constant time, it works on the tuning words the chip would get.
+// @param[in]:  Start frequency in Hz
+// @param[in]:  Delta frequency in Hz
+// @param[in/out]: Increment number 2..4095, reduced to the last safe step if clamping is enabled
+// @param[in]:  INCREMENTAL_SWEEP / DECREMENTAL_SWEEP
+// @param[in]:  true: clamp the increment number instead of rejecting the scan
+// @return:     0 if the scan is safe, 1 if the increment number was clamped, 0xFFF0 if the scan is rejected.
+// ....................................................................................................................
+s32 AD5932_ValidateSweep(u32 startFreq, u32 deltaFreq, u32* increment, AD5932_SweepType_t sweepType, bool clamp)
+{
+	return AD5932_ValidateSweepWords(AD5932_FrequencyToWord(startFreq), AD5932_FrequencyToWord(deltaFreq), increment, sweepType, clamp);
+}
 
-	ret = AD5932_SetDeltaFrequency(deltaFrerq, SWEEPTYPE);
-	if (ret < 0)
-		return -3;
+// ....................................................................................................................
+// @brief:      AD5932_ValidateSweep() on tuning words, for chips with their own MCLK (see ad5932_dev.c).
+//				The end of the scan is found by division, so nothing can overflow.
+// @param[in]:  Start tuning word
+// @param[in]:  Delta tuning word
+// @param[in/out]: Increment number 2..4095, reduced to the last safe step if clamping is enabled
+// @param[in]:  INCREMENTAL_SWEEP / DECREMENTAL_SWEEP
+// @param[in]:  true: clamp the increment number instead of rejecting the scan
+// @return:     0 if the scan is safe, 1 if the increment number was clamped, 0xFFF0 if the scan is rejected.
+// ....................................................................................................................
+s32 AD5932_ValidateSweepWords(u32 startWord, u32 deltaWord, u32* increment, AD5932_SweepType_t sweepType, bool clamp)
+{
+	u32 maxIncrement;
 
-	ret = AD5932_SetIncrementIntervall(incIntervall, INCRTYPE);
-	if (ret < 0)
-		return -4;
+	if ((*increment < 2) || (*increment > 4095))
+		return AD5932_PARAM_ERROR;
 
-	ret = AD5932_SetIncrement(increment);
-	if (ret < 0)
-		return -5;
+	if ((startWord == 0) || (startWord >= AD5932_NYQUIST_WORD) || (deltaWord >= AD5932_NYQUIST_WORD))
+		return AD5932_PARAM_ERROR;
+	if (deltaWord == 0)
+		return 0;
 
-	if (TRIGGER == AUTOMATIC_TRIGGER)
-		AD5932_TriggerCTRLPin();
-	return 0;
+	//the last safe step: below Nyquist upwards, above zero downwards
+	if (sweepType == DECREMENTAL_SWEEP)
+		maxIncrement = (startWord - 1) / deltaWord;
+	else
+		maxIncrement = (AD5932_NYQUIST_WORD - 1 - startWord) / deltaWord;
+
+	if (*increment <= maxIncrement)
+		return 0;
+	if (!clamp || (maxIncrement < 2))
+		return AD5932_PARAM_ERROR;
+
+	*increment = maxIncrement;
+	return 1;
 }
 
 // ....................................................................................................................
@@ -396,7 +871,7 @@ s32 AD5932_SweepGenerator(u32 startFreq, u32 deltaFrerq, u32 increment, AD5932_I
 s32 AD5932_TestSetup(void)
 {
 	s32 ret;
-	AD5932_SetCTRLPin(false);
+	AD5932_CTRL_CLR();
 
 	ret = AD5932_SetControlRegister(DAC_EN, SINE_OUT, MSBOUT_EN, AUTOMATIC_TRIGGER, SYNCSEL_END, SYNCOUT_EN);
 	if (ret < 0)
@@ -422,4 +897,586 @@ s32 AD5932_TestSetup(void)
 	return 0;
 }
 
+// ....................................................................................................................
+// @brief:      Production self test: outputs each frequency with MSBOUT_EN and checks the MSBOUT frequency measured by the
+//				AD5932_SetFreqMeter() meter. The tuning word is truncated, so the chip outputs up to MCLK / 2^24 below
+//				the requested frequency: a point is checked against the frequency of its programmed word, and passes if
+//				the error is within 1Hz (the Hz of that frequency are truncated) and the meter tolerance.
+//				The run time is set by the meter, use a capture based period measurement (a few periods) to finish in
+//				milliseconds.
+//				The AD5932 is left in single frequency mode at the last point.
+// @param[in]:  Frequencies to check in Hz
+// @param[in]:  Number of frequencies
+// @param[out]: Measured minus programmed frequency in Hz for each point, can be NULL
+// @param[in]:  Allowed frequency meter error in Hz
+// @return:     Number of failed points, negative if there is no meter or the AD5932 could not be programmed.
+// ....................................................................................................................
+s32 AD5932_SelfTest(const u32* frequencies, u16 count, s32* errors, u32 tolerance)
+{
+	u32 limit, measured, expected;
+	s32 error, failed = 0;
+	u16 i;
+
+	if (ad5932FreqMeter == NULL)
+		return -1;
+
+	limit = 1 + tolerance;
+	for (i = 0; i < count; i++)
+	{
+		if (AD5932_SingleFrequencyGenerator(frequencies[i], SINE_OUT, MSBOUT_EN, AUTOMATIC_TRIGGER) != 0)
+			return -2;
+
+		expected = AD5932_WordToFrequency(AD5932_FrequencyToWord(frequencies[i]));
+		measured = ad5932FreqMeter();
+		error = (s32)(measured - expected);
+		if (errors != NULL)
+			errors[i] = error;
+		if ((error > (s32)limit) || (error < -(s32)limit))
+			failed++;
+	}
+
+	return failed;
+}
+
+// ....................................................................................................................
+// @brief:      Finds the fastest SCLK rate the board can handle. Starting from maxRate, the rate is lowered by 1/8 until
+//				every test pattern is written and read back correctly through the MSBOUT loopback.
+//				The 12 data bits of both start frequency words are written with alternating bit patterns, so every bit
+//				of the frame toggles. A wrong bit of the low word moves the output by a few Hz only, under the meter
+//				tolerance, so the high word carries the same pattern, cut to the bits up to the highest bit of the
+//				test frequency: there a wrong bit moves the output by MCLK / 4096 or more. The bits above are sent as
+//				0, a bit that turns 1 there is a large jump as well.
+//				The AD5932 is left in single frequency mode at the last tested pattern.
+// @param[in]:  LPC_SSP0 or LPC_SSP1
+// @param[in]:  SSP_CPOL_HI / SSP_CPOL_LO - clock polarity
+// @param[in]:  SSP_CPHA_FIRST / SSP_CPHA_SECOND - clock phase
+// @param[in]:  Lowest and highest SCLK rate to try in Hz
+// @param[in]:  Test frequency in Hz, MCLK / 4096..MCLK / 4, the meter has to measure up to twice of it
+// @param[in]:  Allowed frequency meter error in Hz
+// @return:     The fastest working SCLK rate (the SSP is left at this rate), 0 if none of them worked.
+//				On failure the SSP registers, the port and the rate of the driver are restored.
+// ....................................................................................................................
+u32 AD5932_CalibrateSPI(LPC_SSP_TypeDef* SSPx, u32 CPOL, u32 CPHA, u32 minRate, u32 maxRate, u32 testFreq, u32 tolerance)
+{
+	static const u16 patterns[] = {0x0555, 0x0AAA, 0x0FFF};
+	LPC_SSP_TypeDef* oldPort = SSPPort;
+	u32 oldRate = ad5932SCLK;
+	u32 oldCR0 = SSPx->CR0;
+	u32 oldCR1 = SSPx->CR1;
+	u32 oldCPSR = SSPx->CPSR;
+	u32 rate, mask, word, expected, measured, i;
+	bool passed;
+
+	if ((ad5932FreqMeter == NULL) || (testFreq >= ad5932MCLKCal / 4))
+		return 0;
+
+	//high word bits up to the highest one of the test frequency
+	mask = AD5932_FrequencyToWord(testFreq) >> 12;
+	if (mask == 0)
+		return 0;
+	while (mask & (mask + 1))
+		mask |= mask >> 1;
+
+	if (maxRate > AD5932_SCLK_MAX)
+		maxRate = AD5932_SCLK_MAX;
+
+	for (rate = maxRate; (rate >= minRate) && (rate > 0); rate -= (rate >> 3) ? (rate >> 3) : rate)
+	{
+		AD5932_ConfigSPI(SSPx, CPOL, CPHA, rate);
+
+		passed = true;
+		for (i = 0; (i < sizeof(patterns) / sizeof(patterns[0])) && passed; i++)
+		{
+			//the control register write restarts the state machine, the new start frequency is loaded by CTRL
+			word = ((patterns[i] & mask) << 12) | patterns[i];
+			AD5932_CTRL_CLR();
+			if ((AD5932_SetControlRegister(DAC_EN, SINE_OUT, MSBOUT_EN, EXTERNAL_TRIGGER, SYNCSEL_END, SYNCOUT_EN) != 0) ||
+				(AD5932_SetStartFrequencyWord(word) != 0))
+			{
+				passed = false;
+				break;
+			}
+			AD5932_TriggerCTRLPin();
+
+			expected = AD5932_WordToFrequency(word);
+			measured = ad5932FreqMeter();
+			if ((measured > expected + tolerance) || (measured + tolerance < expected))
+				passed = false;
+		}
+
+		if (passed)
+			return rate;
+	}
+
+	//nothing worked: back to the clock the SSP had before
+	SSP_Cmd(SSPx, DISABLE);
+	SSPx->CR0 = oldCR0;
+	SSPx->CPSR = oldCPSR;
+	SSPx->CR1 = oldCR1;
+	SSPPort = oldPort;
+	ad5932SCLK = oldRate;
+	return 0;
+}
+
+// ....................................................................................................................
+// @brief:      Sets the free running microsecond time base used by the power management.
+// @param[in]:  Function returning the current time in us (wrapping u32), or NULL
+// @return:     none
+// ....................................................................................................................
+void AD5932_SetTimeBase(AD5932_TimeBase_t timeBase)
+{
+	ad5932TimeBase = timeBase;
+}
+
+// ....................................................................................................................
+// @brief:      Puts the AD5932 into / out of standby. The registers are kept, but the output stops.
+// @param[in]:  true: standby, false: wake up
+// @return:     none
+// ....................................................................................................................
+void AD5932_SetStandby(bool state)
+{
+	AD5932_SetSTDBYPin(state);
+	ad5932Standby = state;
+	AD5932_SaveShadow();
+}
+
+// ....................................................................................................................
+// @brief:      Measures the time from releasing STANDBY to a valid output on MSBOUT.
+//				The AD5932 has to produce expectedFreq with MSBOUT_EN before the call (ie. AD5932_SingleFrequencyGenerator()).
+//				The result is used by AD5932_PowerTask() to wake the chip in time.
+// @param[in]:  Expected MSBOUT frequency in Hz
+// @param[in]:  Allowed frequency meter error in Hz
+// @param[in]:  Timeout in us
+// @return:     The wake-up latency in us, 0 if it was not measurable (no meter / time base, or timeout).
+// ....................................................................................................................
+u32 AD5932_MeasureWakeLatency(u32 expectedFreq, u32 tolerance, u32 timeout)
+{
+	u32 start, elapsed, measured;
+
+	if ((ad5932FreqMeter == NULL) || (ad5932TimeBase == NULL))
+		return 0;
+
+	AD5932_SetStandby(true);
+	delay_us(100);
+
+	start = ad5932TimeBase();
+	AD5932_SetStandby(false);
+	do
+	{
+		measured = ad5932FreqMeter();
+		elapsed = ad5932TimeBase() - start;
+		if ((measured <= expectedFreq + tolerance) && (measured + tolerance >= expectedFreq))
+		{
+			if (elapsed == 0)
+				elapsed = 1;
+			ad5932WakeLatency = elapsed;
+			return elapsed;
+		}
+	} while (elapsed < timeout);
+
+	return 0;
+}
+
+// ....................................................................................................................
+// @brief:      Enables / disables the automatic standby between scheduled sweeps.
+// @param[in]:  true: enable, false: disable (the chip is woken up)
+// @return:     none
+// ....................................................................................................................
+void AD5932_SetPowerPolicy(bool enable)
+{
+	ad5932PowerPolicy = enable;
+	if (!enable && ad5932Standby)
+		AD5932_SetStandby(false);
+}
+
+// ....................................................................................................................
+// @brief:      Tells the power management when a sweep starts and how long it runs.
+//				The chip is kept awake in the [start - wake latency, start + duration] window. Windows are queued by
+//				their start, so the next burst can be announced while a sweep runs: the running window is kept
+//				until its end passes.
+// @param[in]:  Sweep start time in us (AD5932_SetTimeBase() time)
+// @param[in]:  Sweep duration in us
+// @return:     0 if OK, 0xFFF0 if AD5932_SCHEDULE_DEPTH windows are waiting already.
+// ....................................................................................................................
+s32 AD5932_ScheduleSweep(u32 startTime, u32 duration)
+{
+	u08 i;
+
+	if (ad5932SweepScheduled >= AD5932_SCHEDULE_DEPTH)
+		return AD5932_PARAM_ERROR;
+
+	//insert by start, the times are compared as differences, so the wrap of the time base does not matter
+	for (i = ad5932SweepScheduled; (i > 0) && ((s32)(startTime - ad5932SweepStart[i - 1]) < 0); i--)
+	{
+		ad5932SweepStart[i] = ad5932SweepStart[i - 1];
+		ad5932SweepEnd[i] = ad5932SweepEnd[i - 1];
+	}
+	ad5932SweepStart[i] = startTime;
+	ad5932SweepEnd[i] = startTime + duration;
+	ad5932SweepScheduled++;
+	return 0;
+}
+
+// ....................................................................................................................
+// @brief:      Power management task, call it periodically from the main loop.
+//				Drops the chip into standby when no sweep is due, and wakes it up ahead of the next scheduled one.
+//				Windows whose end has passed are removed first, the decision is made against the earliest one left.
+//				Short gaps (less than twice the wake latency) are not worth sleeping.
+// @param[in]:  none
+// @return:     none
+// ....................................................................................................................
+void AD5932_PowerTask(void)
+{
+	u32 now;
+	s32 toStart;
+	u08 i, kept;
+
+	if (!ad5932PowerPolicy || (ad5932TimeBase == NULL))
+		return;
+
+	now = ad5932TimeBase();
+
+	//drop the windows that are over, the order of the rest is kept
+	kept = 0;
+	for (i = 0; i < ad5932SweepScheduled; i++)
+	{
+		if ((s32)(ad5932SweepEnd[i] - now) < 0)
+			continue;
+		ad5932SweepStart[kept] = ad5932SweepStart[i];
+		ad5932SweepEnd[kept] = ad5932SweepEnd[i];
+		kept++;
+	}
+	ad5932SweepScheduled = kept;
+
+	if (!ad5932SweepScheduled)
+	{
+		//nothing is running or scheduled
+		if (!ad5932Standby)
+			AD5932_SetStandby(true);
+		return;
+	}
+
+	toStart = (s32)(ad5932SweepStart[0] - now);
+
+	if (toStart <= (s32)(ad5932WakeLatency + AD5932_WAKE_MARGIN))
+	{
+		if (ad5932Standby)
+			AD5932_SetStandby(false);
+	}
+	else if (toStart > (s32)(2 * ad5932WakeLatency + AD5932_WAKE_MARGIN))
+	{
+		if (!ad5932Standby)
+			AD5932_SetStandby(true);
+	}
+}
+
+// ....................................................................................................................
+// @brief:      The sweep parameters as they were sent to the AD5932 (the chip has no readback).
+// @param[in]:  none
+// @return:     Pointer to the programmed sweep, see ad5932_scan for the step / time calculations.
+// ....................................................................................................................
+const AD5932Sweep_t* AD5932_GetSweep(void)
+{
+	return &ad5932Sweep;
+}
+
+// ....................................................................................................................
+// @brief:      The tuning word factor of the calibrated MCLK, for AD5932_FactorToWord() in batch conversions.
+// @param[in]:  none
+// @return:     2^56 / MCLK, truncated. MCLK itself is AD5932_GetSweep()->mclk.
+// ....................................................................................................................
+u64 AD5932_GetFreqFactor(void)
+{
+	return ad5932FreqFactor;
+}
+
+// ....................................................................................................................
+// @brief:      Stores the sweep start time, if the CTRL pin is not driven by AD5932_TriggerCTRLPin()
+// @param[in]:  CTRL rising edge time in us (AD5932_SetTimeBase() time)
+// @return:     none
+// ....................................................................................................................
+void AD5932_MarkTrigger(u32 timestamp)
+{
+	ad5932TriggerTime = timestamp;
+	AD5932_SaveShadow();
+}
+
+// ....................................................................................................................
+// @brief:      Time of the last CTRL trigger, taken from the AD5932_SetTimeBase() time base.
+// @param[in]:  none
+// @return:     Trigger time in us
+// ....................................................................................................................
+u32 AD5932_GetTriggerTime(void)
+{
+	return ad5932TriggerTime;
+}
+
+// ....................................................................................................................
+// @brief:      Measures the real MCLK frequency through MSBOUT and applies the correction with AD5932_SetMCLKCorrection().
+//				Use the highest test frequency the meter can measure accurately, the resolution of the result is
+//				the relative resolution of the meter. The AD5932 is left in single frequency mode.
+// @param[in]:  Test frequency in Hz
+// @return:     The MCLK error in ppb, 0 (and no correction) if the measurement failed.
+// ....................................................................................................................
+s32 AD5932_CalibrateMCLK(u32 testFreq)
+{
+	u32 word, measured;
+	s64 realMCLK;
+
+	if (ad5932FreqMeter == NULL)
+		return 0;
+
+	AD5932_SetMCLKCorrection(0);
+	word = AD5932_FrequencyToWord(testFreq);
+	if ((word == 0) || (word >= AD5932_ACCU_RESOLUTION / 2))
+		return 0;
+
+	if (AD5932_SingleFrequencyGenerator(testFreq, SINE_OUT, MSBOUT_EN, AUTOMATIC_TRIGGER) != 0)
+		return 0;
+
+	measured = ad5932FreqMeter();
+	if (measured == 0)
+		return 0;
+
+	//f = word * MCLK / 2^24, so the real MCLK is measured * 2^24 / word
+	//the temperature table error of the moment is not part of the calibration
+	realMCLK = ((s64)measured * AD5932_ACCU_RESOLUTION + word / 2) / word;
+	AD5932_SetMCLKCorrection((s32)((realMCLK - ad5932MCLK) * 1000000000 / ad5932MCLK) - ad5932TempCorrection);
+	return ad5932MCLKCorrection;
+}
+
+// ....................................................................................................................
+// @brief:      Sets the MCLK temperature error table. The table holds the crystal error at tempMin, tempMin + tempStep, ...
+//				The error is interpolated at the middle of bucketWidth wide temperature buckets, and the tuning word
+//				factor is only recalculated when AD5932_SetTemperature() moves to another bucket.
+// @param[in]:  Table of MCLK errors in ppb, relative to the calibrated MCLK. NULL removes the table.
+// @param[in]:  Number of table entries (min. 2)
+// @param[in]:  Temperature of the first entry in 0.1 C
+// @param[in]:  Temperature step between the entries in 0.1 C
+// @param[in]:  Bucket width in 0.1 C
+// @return:     none
+// ....................................................................................................................
+void AD5932_SetTempTable(const s32* ppb, u16 count, s16 tempMin, u16 tempStep, u16 bucketWidth)
+{
+	if ((ppb == NULL) || (count < 2) || (tempStep == 0) || (bucketWidth == 0))
+		ad5932TempTable = NULL;
+	else
+		ad5932TempTable = ppb;
+
+	ad5932TempCount = count;
+	ad5932TempMin = tempMin;
+	ad5932TempStep = tempStep;
+	ad5932TempBucketWidth = bucketWidth;
+	ad5932TempBucket = 0x7FFFFFFF;		//forces recalculation at the next temperature
+	ad5932TempCorrection = 0;
+	AD5932_UpdateMCLK();
+}
+
+// ....................................................................................................................
+// @brief:      Updates the MCLK temperature correction. Cheap if the temperature stays in the same bucket.
+// @param[in]:  Temperature in 0.1 C
+// @return:     none
+// ....................................................................................................................
+void AD5932_SetTemperature(s16 temp)
+{
+	s32 bucket, center, offset, index, frac;
+
+	if (ad5932TempTable == NULL)
+		return;
+
+	//floor division, the temperature can be below zero
+	offset = (s32)temp - ad5932TempMin;
+	bucket = (offset >= 0) ? offset / ad5932TempBucketWidth : -((-offset + ad5932TempBucketWidth - 1) / ad5932TempBucketWidth);
+	if (bucket == ad5932TempBucket)
+		return;
+	ad5932TempBucket = bucket;
+
+	center = bucket * ad5932TempBucketWidth + ad5932TempBucketWidth / 2;
+	if (center <= 0)
+		ad5932TempCorrection = ad5932TempTable[0];
+	else if (center >= (s32)(ad5932TempCount - 1) * ad5932TempStep)
+		ad5932TempCorrection = ad5932TempTable[ad5932TempCount - 1];
+	else
+	{
+		index = center / ad5932TempStep;
+		frac = center - index * ad5932TempStep;
+		ad5932TempCorrection = ad5932TempTable[index] +
+			(s32)(((s64)(ad5932TempTable[index + 1] - ad5932TempTable[index]) * frac) / ad5932TempStep);
+	}
+
+	AD5932_UpdateMCLK();
+}
+
+#if AD5932_USE_PWM_CTRL
+// ....................................................................................................................
+// @brief:      Programs a GPDMA channel for timer match requested, memory to peripheral word transfers.
+// @param[in]:  Channel 0..7
+// @param[in]:  Source and destination address, first linked list item (0 if none)
+// @param[in]:  DMACCControl value: transfer size, widths and increments
+// @param[in]:  DMA request line
+// @return:     none
+// ....................................................................................................................
+static void AD5932_PWMDMAChannel(u08 channel, u32 src, u32 dst, u32 lli, u32 control, u08 request)
+{
+	LPC_GPDMACH_TypeDef* ch = AD5932_DMA_CH(channel);
+
+	ch->DMACCConfig = 0;
+	LPC_GPDMA->DMACIntTCClear = 1UL << channel;
+	LPC_GPDMA->DMACIntErrClr = 1UL << channel;
+	ch->DMACCSrcAddr = src;
+	ch->DMACCDestAddr = dst;
+	ch->DMACCLLI = lli;
+	ch->DMACCControl = control;
+	ch->DMACCConfig = AD5932_DMA_ENABLE | ((u32)request << 6) | AD5932_DMA_M2P;
+}
+
+// ....................................................................................................................
+// @brief:      Sets up the timer in us resolution and the two DMA channels, then starts the CTRL edges.
+//				MR0 is the dwell of the running step: its match resets the counter and sets MATx.0 (CTRL rising edge),
+//				and requests the dwell channel, which loads MR0 with the dwell of the step that just started. The
+//				edge of the last step gets the linked item instead, which sets stop on MR1 in MCR. MR1 is the end of
+//				the CTRL pulse: its match requests the pulse channel, which clears MATx.0 through EMR (the list links
+//				to itself). A step lasts MR0 + 1 ticks, as the reset comes one tick after the match.
+// @param[in]:  Timer 0..3
+// @param[in]:  Dwell table, NULL for a fixed dwell
+// @param[in]:  MR0 of the first step (a fixed dwell - 1, or the first entry of the table)
+// @param[in]:  Number of frequency steps (NINCR) 2..4095
+// @return:     0 if OK, 0xFFF0 if range error.
+// ....................................................................................................................
+static s32 AD5932_PWMStart(u08 timer, const u32* dwellTable, u32 dwell, u16 steps)
+{
+	TIM_TIMERCFG_Type timerCfg;
+	LPC_TIM_TypeDef* tim;
+	u08 request;
+
+	if ((timer > 3) || (steps < 2) || (steps > 4095) || (dwell <= AD5932_CTRL_PWM_PULSE) || ad5932PWMBusy)
+		return AD5932_PARAM_ERROR;
+
+	tim = ad5932PWMTimers[timer];
+	request = AD5932_DMA_MAT_REQUEST + 2 * timer;
+	ad5932PWMTimer = timer;
+	ad5932PWMBusy = true;
+
+	timerCfg.PrescaleOption = TIM_PRESCALE_USVAL;
+	timerCfg.PrescaleValue = 1;
+	TIM_Init(tim, TIM_TIMER_MODE, &timerCfg);		//powered, 1 us tick, counter stopped
+	tim->TCR = 2;									//counter held in reset
+	tim->IR = 0x3F;
+	tim->MR0 = dwell;
+	tim->MR1 = AD5932_CTRL_PWM_PULSE;
+	tim->MCR = AD5932_TIM_MR0R;
+
+	ad5932PWMDwell = dwell;
+	if (dwellTable != NULL)
+		dwellTable++;									//the first one is in MR0 already
+	ad5932PWMPulseEnd = AD5932_TIM_EMC0_SET;
+	ad5932PWMStopMCR = AD5932_TIM_MR0R | AD5932_TIM_MR1S;
+
+	LPC_SC->PCONP |= AD5932_PCONP_GPDMA;
+	LPC_GPDMA->DMACConfig = 1;
+	LPC_SC->DMAREQSEL |= 3UL << (request - AD5932_DMA_MAT_REQUEST);		//MATx.0 / MATx.1 instead of the UART requests
+
+	//dwell channel: the dwell of steps 2..NINCR-1, one per CTRL edge, then the stop on the edge of the last step,
+	//so the timer halts at the end of its pulse and there is no edge past NINCR
+	ad5932PWMStopLLI.SrcAddr = (u32)&ad5932PWMStopMCR;
+	ad5932PWMStopLLI.DstAddr = (u32)&tim->MCR;
+	ad5932PWMStopLLI.NextLLI = 0;
+	ad5932PWMStopLLI.Control = 1 | AD5932_DMA_WORDS;
+	if (steps == 2)
+		AD5932_PWMDMAChannel(AD5932_CTRL_DMA_DWELL, ad5932PWMStopLLI.SrcAddr, ad5932PWMStopLLI.DstAddr, 0,
+				ad5932PWMStopLLI.Control, request);
+	else
+		AD5932_PWMDMAChannel(AD5932_CTRL_DMA_DWELL, (dwellTable != NULL) ? (u32)dwellTable : (u32)&ad5932PWMDwell,
+				(u32)&tim->MR0, (u32)&ad5932PWMStopLLI,
+				(steps - 2) | AD5932_DMA_WORDS | ((dwellTable != NULL) ? AD5932_DMA_SI : 0), request);
+
+	//pulse channel: ends every CTRL pulse, for as long as the timer runs
+	ad5932PWMPulseLLI.SrcAddr = (u32)&ad5932PWMPulseEnd;
+	ad5932PWMPulseLLI.DstAddr = (u32)&tim->EMR;
+	ad5932PWMPulseLLI.NextLLI = (u32)&ad5932PWMPulseLLI;
+	ad5932PWMPulseLLI.Control = 1 | AD5932_DMA_WORDS;
+	AD5932_PWMDMAChannel(AD5932_CTRL_DMA_PULSE, (u32)&ad5932PWMPulseEnd, (u32)&tim->EMR, (u32)&ad5932PWMPulseLLI,
+			1 | AD5932_DMA_WORDS, request + 1);
+
+	if (ad5932TimeBase != NULL)
+		ad5932TriggerTime = ad5932TimeBase();
+	AD5932_SaveShadow();
+
+	//the first edge starts the scan, the MR0 matches step it
+	tim->EMR = AD5932_TIM_EMC0_SET | AD5932_TIM_EM0;
+	tim->TCR = 1;
+	return 0;
+}
+
+// ....................................................................................................................
+// @brief:      Steps a sweep programmed with EXTERNAL_TRIGGER by timer generated CTRL edges, with a fixed dwell per step.
+//				The dwell is not limited by the TINT range, and the CPU does nothing per step.
+// @param[in]:  Timer 0..3, its MATx.0 output connected to CTRL. The timer and its MR0 / MR1 DMA requests are used up.
+// @param[in]:  Dwell time per step in us, more than AD5932_CTRL_PWM_PULSE + 1
+// @param[in]:  Number of frequency steps, the programmed NINCR 2..4095
+// @return:     0 if OK, 0xFFF0 if range error or the stepping is running.
+// ....................................................................................................................
+s32 AD5932_StartPWMStepping(u08 timer, u32 dwell, u16 steps)
+{
+	if (dwell <= AD5932_CTRL_PWM_PULSE + 1)
+		return AD5932_PARAM_ERROR;
+	return AD5932_PWMStart(timer, NULL, dwell - 1, steps);
+}
+
+// ....................................................................................................................
+// @brief:      Same as AD5932_StartPWMStepping(), but every step has its own dwell time.
+//				The dwell channel walks the table, one entry per CTRL edge, so the CPU does nothing per step here too.
+// @param[in]:  Timer 0..3, its MATx.0 output connected to CTRL
+// @param[in]:  MR0 values (steps entries): a step lasts its entry + 1 us, so store the dwell - 1. Each more than
+//				AD5932_CTRL_PWM_PULSE. The GPDMA reads it, so keep it in RAM, valid while running. The entry of the last
+//				step is not used, the scan stays there.
+// @param[in]:  Number of frequency steps, the programmed NINCR 2..4095
+// @return:     0 if OK, 0xFFF0 if range error (also an entry of AD5932_CTRL_PWM_PULSE or less) or the stepping is running.
+// ....................................................................................................................
+s32 AD5932_StartPWMSteppingTable(u08 timer, const u32* dwellTable, u16 steps)
+{
+	u16 i;
+
+	if ((dwellTable == NULL) || (steps < 2) || (steps > 4095))
+		return AD5932_PARAM_ERROR;
+	for (i = 0; i < steps; i++)
+		if (dwellTable[i] <= AD5932_CTRL_PWM_PULSE)
+			return AD5932_PARAM_ERROR;
+
+	return AD5932_PWMStart(timer, dwellTable, dwellTable[0], steps);
+}
+
+// ....................................................................................................................
+// @brief:      Stops the CTRL edges and frees the DMA channels. CTRL is left low.
+// @param[in]:  none
+// @return:     none
+// ....................................................................................................................
+void AD5932_StopPWMStepping(void)
+{
+	LPC_TIM_TypeDef* tim = ad5932PWMTimers[ad5932PWMTimer];
+
+	if (!ad5932PWMBusy)
+		return;
+
+	tim->TCR = 0;
+	AD5932_DMA_CH(AD5932_CTRL_DMA_DWELL)->DMACCConfig = 0;
+	AD5932_DMA_CH(AD5932_CTRL_DMA_PULSE)->DMACCConfig = 0;
+	tim->EMR = 0;
+	ad5932PWMBusy = false;
+}
+
+// ....................................................................................................................
+// @brief:      Tells if the stepping is still running. The timer stops itself at the end of the last CTRL pulse,
+//				the DMA channels are freed by the first call after that.
+// @param[in]:  none
+// @return:     true while there are CTRL edges to go
+// ....................................................................................................................
+bool AD5932_PWMSteppingBusy(void)
+{
+	if (ad5932PWMBusy && !(ad5932PWMTimers[ad5932PWMTimer]->TCR & 1))
+		AD5932_StopPWMStepping();
+	return ad5932PWMBusy;
+}
+#endif
+
 #endif
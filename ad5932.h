@@ -12,17 +12,124 @@
 
 #include "defs.h"
 
-#if (MCU_FAMILY == LPC175X6X) || (MCU_FAMILY == LPC177X8X_LPC407X8X)
+#if !defined(MCU_FAMILY)
+	typedef struct _LPC_SSP_TypeDef LPC_SSP_TypeDef;	//host builds (tools, simulations) only use the calculation modules
+#elif (MCU_FAMILY == LPC175X6X) || (MCU_FAMILY == LPC177X8X_LPC407X8X)
 	#include "lpc17xx_ssp.h"
 	#include "lpc17xx_gpio.h"
+	#include "lpc17xx_timer.h"
+	#include "lpc17xx_gpdma.h"
+	#ifndef AD5932_USE_PWM_CTRL
+		#define AD5932_USE_PWM_CTRL	1		//CTRL stepping by a timer match output and GPDMA (AD5932_StartPWMStepping()), 0 to leave it out
+	#endif
 #elif (MCU_FAMILY == LPC55XX) || (MCU_FAMILY == LPC54XXX)
 	#include "LPC5x_spi.h"
 	#include "LPC5x_gpio.h"
 #endif
 
+//Pin bindings. Each pin is set / cleared by a macro, so the SPI path of the driver's own chip (AD5932_SendSPICommand())
+//has no call and no branch per pin change.
+//Define AD5932_xxx_PORT (ie. LPC_GPIO0) and AD5932_xxx_BIT for a single FIOSET / FIOCLR store,
+//define AD5932_PIN_MOCK to record the pin levels in ad5932PinMock (host tests and models, ad5932PinMockHook is called
+//after every change if set),
+//or define AD5932_xxx_SET() / AD5932_xxx_CLR() yourself. The default is the SPARE0..3 macros of rio.h.
+#define AD5932_PIN_FSYNC		0x01
+#define AD5932_PIN_STDBY		0x02
+#define AD5932_PIN_CTRL			0x04
+#define AD5932_PIN_INT			0x08
+
+#if defined(AD5932_PIN_MOCK)
+	extern volatile u08 ad5932PinMock;
+	extern void (*ad5932PinMockHook)(void);
+	#define AD5932_PIN_MOCK_SET(pin)	(ad5932PinMock |= (pin), (ad5932PinMockHook != NULL) ? ad5932PinMockHook() : (void)0)
+	#define AD5932_PIN_MOCK_CLR(pin)	(ad5932PinMock &= (u08)~(pin), (ad5932PinMockHook != NULL) ? ad5932PinMockHook() : (void)0)
+	#define AD5932_FSYNC_SET()			AD5932_PIN_MOCK_SET(AD5932_PIN_FSYNC)
+	#define AD5932_FSYNC_CLR()			AD5932_PIN_MOCK_CLR(AD5932_PIN_FSYNC)
+	#define AD5932_STDBY_SET()			AD5932_PIN_MOCK_SET(AD5932_PIN_STDBY)
+	#define AD5932_STDBY_CLR()			AD5932_PIN_MOCK_CLR(AD5932_PIN_STDBY)
+	#define AD5932_CTRL_SET()			AD5932_PIN_MOCK_SET(AD5932_PIN_CTRL)
+	#define AD5932_CTRL_CLR()			AD5932_PIN_MOCK_CLR(AD5932_PIN_CTRL)
+	#define AD5932_INT_SET()			AD5932_PIN_MOCK_SET(AD5932_PIN_INT)
+	#define AD5932_INT_CLR()			AD5932_PIN_MOCK_CLR(AD5932_PIN_INT)
+#endif
+
+#ifndef AD5932_FSYNC_SET
+	#if defined(AD5932_FSYNC_PORT)
+		#define AD5932_FSYNC_SET()		((AD5932_FSYNC_PORT)->FIOSET = 1UL << (AD5932_FSYNC_BIT))
+		#define AD5932_FSYNC_CLR()		((AD5932_FSYNC_PORT)->FIOCLR = 1UL << (AD5932_FSYNC_BIT))
+	#else
+		#define AD5932_FSYNC_SET()		SPARE0_on()
+		#define AD5932_FSYNC_CLR()		SPARE0_off()
+	#endif
+#endif
+#ifndef AD5932_STDBY_SET
+	#if defined(AD5932_STDBY_PORT)
+		#define AD5932_STDBY_SET()		((AD5932_STDBY_PORT)->FIOSET = 1UL << (AD5932_STDBY_BIT))
+		#define AD5932_STDBY_CLR()		((AD5932_STDBY_PORT)->FIOCLR = 1UL << (AD5932_STDBY_BIT))
+	#else
+		#define AD5932_STDBY_SET()		SPARE1_on()
+		#define AD5932_STDBY_CLR()		SPARE1_off()
+	#endif
+#endif
+#ifndef AD5932_CTRL_SET
+	#if defined(AD5932_CTRL_PORT)
+		#define AD5932_CTRL_SET()		((AD5932_CTRL_PORT)->FIOSET = 1UL << (AD5932_CTRL_BIT))
+		#define AD5932_CTRL_CLR()		((AD5932_CTRL_PORT)->FIOCLR = 1UL << (AD5932_CTRL_BIT))
+	#else
+		#define AD5932_CTRL_SET()		SPARE2_on()
+		#define AD5932_CTRL_CLR()		SPARE2_off()
+	#endif
+#endif
+#ifndef AD5932_INT_SET
+	#if defined(AD5932_INT_PORT)
+		#define AD5932_INT_SET()		((AD5932_INT_PORT)->FIOSET = 1UL << (AD5932_INT_BIT))
+		#define AD5932_INT_CLR()		((AD5932_INT_PORT)->FIOCLR = 1UL << (AD5932_INT_BIT))
+	#else
+		#define AD5932_INT_SET()		SPARE3_on()
+		#define AD5932_INT_CLR()		SPARE3_off()
+	#endif
+#endif
+
+//Critical sections of the ownership, bus arbiter and trace code. The caller's PRIMASK is saved and restored, not
+//cleared, so they nest and can be used from interrupts or with the interrupts already disabled. Host models
+//(AD5932_PIN_MOCK) run on one thread, the sections are empty there. Define both macros yourself for other cores.
+#ifndef AD5932_CRITICAL_ENTER
+	#if defined(AD5932_PIN_MOCK)
+		#define AD5932_CRITICAL_ENTER(mask)	((mask) = 0)
+		#define AD5932_CRITICAL_EXIT(mask)	((void)(mask))
+	#else
+		#define AD5932_CRITICAL_ENTER(mask)	((mask) = __get_PRIMASK(), __disable_irq())
+		#define AD5932_CRITICAL_EXIT(mask)	__set_PRIMASK(mask)
+	#endif
+#endif
+
 #define AD5932_PORT_BUSY		0xFFFF
 #define AD5932_PARAM_ERROR		0xFFF0
 #define AD5932_ACCU_RESOLUTION	0x1000000
+#define AD5932_NYQUIST_WORD		0x800000	//MCLK/2 tuning word
+#define AD5932_SCLK_MAX			40000000	//t1 SCLK cycle time is min. 25ns
+
+#define AD5932_CTRL_PWM_PULSE	2		//us, CTRL high time in PWM stepping mode
+#ifndef AD5932_CTRL_DMA_DWELL
+	#define AD5932_CTRL_DMA_DWELL	6		//GPDMA channel loading the dwell times in PWM stepping mode
+#endif
+#ifndef AD5932_CTRL_DMA_PULSE
+	#define AD5932_CTRL_DMA_PULSE	7		//GPDMA channel ending the CTRL pulses in PWM stepping mode
+#endif
+#define AD5932_WAKE_LATENCY_DEFAULT	1000	//us, used until AD5932_MeasureWakeLatency() is called
+#define AD5932_WAKE_MARGIN			100		//us, extra time added to the wake-up latency
+#ifndef AD5932_SCHEDULE_DEPTH
+	#define AD5932_SCHEDULE_DEPTH	4		//sweep windows AD5932_ScheduleSweep() can hold ahead
+#endif
+
+//MSBOUT frequency measurement function, returns Hz
+typedef u32 (*AD5932_FreqMeter_t)(void);
+
+//FSYNC control of a chip, if more AD5932 share the bus
+typedef void (*AD5932_ChipSelect_t)(u08 chip, bool state);
+
+//free running time base, returns us
+typedef u32 (*AD5932_TimeBase_t)(void);
 
 //parameter structure for external use
 typedef struct
@@ -35,6 +142,18 @@ typedef struct
 	bool sweepType;
 } AD5932Params_t;
 
+//programmed sweep in tuning words, as the chip sees it
+typedef struct
+{
+	u32 mclk;				//MCLK frequency in Hz
+	u32 startWord;			//FSTART, 24 bit
+	u32 deltaWord;			//DFREQ, 23 bit
+	u16 increment;			//NINCR, 2..4095
+	u16 intervall;			//TINT, 2..2047
+	bool incrementBase;		//AD5932_IncIntervall_t
+	bool sweepType;			//AD5932_SweepType_t
+} AD5932Sweep_t;
+
 //config bits
 typedef enum _RegBits_t
 {
@@ -79,12 +198,60 @@ typedef enum _AD5932_IncIntervall_t
 	MCLK_INP_BASED			= false		//Increment interval based on fixed number of clock periods
 } AD5932_IncIntervall_t;
 
+//Frequency to tuning word with a precalculated factor (2^56 / MCLK, truncated), shared by the driver, the device
+//contexts and the batch conversion of ad5932_bank.c. Inline and branch free, so batch loops can be vectorized.
+//The factor is truncated, so the product is the exact quotient or one less, the compare adds the missing one.
+//The result is truncated (floor(value * 2^24 / MCLK)), saturated to 0xFFFFFF at or above MCLK.
+static inline u32 AD5932_FactorToWord(u32 value, u64 factor, u32 mclk)
+{
+	u32 word = ((u64)value * factor) >> 32;
+
+	word += ((u64)(word + 1) * mclk <= ((u64)value << 24));
+	return (value >= mclk) ? 0x00FFFFFF : word;
+}
+
 void AD5932_SetSPI(LPC_SSP_TypeDef* SSPx);
+u32 AD5932_ConfigSPI(LPC_SSP_TypeDef* SSPx, u32 CPOL, u32 CPHA, u32 clockRate);
+u32 AD5932_CalibrateSPI(LPC_SSP_TypeDef* SSPx, u32 CPOL, u32 CPHA, u32 minRate, u32 maxRate, u32 testFreq, u32 tolerance);
+void AD5932_SetFreqMeter(AD5932_FreqMeter_t meter);
+s32 AD5932_SendSPICommand(u16 commandWord);
+s32 AD5932_SendSPICommandCS(u16 commandWord, AD5932_ChipSelect_t chipSelect, u08 chip);
+s32 AD5932_SendSPICommandOn(LPC_SSP_TypeDef* SSPx, u16 commandWord, AD5932_ChipSelect_t chipSelect, u08 chip);
+void AD5932_DecodeCommand(u16 commandWord, AD5932Sweep_t* sweep, u16* control);
 void AD5932_Init(u32 MCLK);
+bool AD5932_WarmInit(u32 MCLK);
+void AD5932_SaveShadow(void);
+void AD5932_SetMCLKCorrection(s32 ppb);
+s32 AD5932_CalibrateMCLK(u32 testFreq);
+void AD5932_SetTempTable(const s32* ppb, u16 count, s16 tempMin, u16 tempStep, u16 bucketWidth);
+void AD5932_SetTemperature(s16 temp);
+u32 AD5932_FrequencyToWord(u32 value);
+u32 AD5932_WordToFrequency(u32 word);
+void AD5932_SetCTRLPin(bool state);
 void AD5932_TriggerCTRLPin(void);
 void AD5932_TriggerINTPin(void);
 s32 AD5932_SingleFrequencyGenerator(u32 frequency, RegBits_t WAVE_TYPE, RegBits_t MSBOUT, RegBits_t TRIGGER);
 s32 AD5932_SweepGenerator(u32 startFreq, u32 deltaFrerq, u32 increment, AD5932_IncIntervall_t INCRTYPE, u32 incIntervall, RegBits_t SWEEPTYPE, RegBits_t WAVE_TYPE, RegBits_t MSBOUT, RegBits_t TRIGGER, RegBits_t SYNCSEL, RegBits_t SYNCOUT);
+s32 AD5932_SetStartFrequencyWord(u32 word);
+s32 AD5932_ValidateSweep(u32 startFreq, u32 deltaFreq, u32* increment, AD5932_SweepType_t sweepType, bool clamp);
+s32 AD5932_ValidateSweepWords(u32 startWord, u32 deltaWord, u32* increment, AD5932_SweepType_t sweepType, bool clamp);
 s32 AD5932_TestSetup(void);
+s32 AD5932_SelfTest(const u32* frequencies, u16 count, s32* errors, u32 tolerance);
+void AD5932_SetTimeBase(AD5932_TimeBase_t timeBase);
+void AD5932_SetStandby(bool state);
+u32 AD5932_MeasureWakeLatency(u32 expectedFreq, u32 tolerance, u32 timeout);
+void AD5932_SetPowerPolicy(bool enable);
+s32 AD5932_ScheduleSweep(u32 startTime, u32 duration);
+void AD5932_PowerTask(void);
+const AD5932Sweep_t* AD5932_GetSweep(void);
+u64 AD5932_GetFreqFactor(void);
+void AD5932_MarkTrigger(u32 timestamp);
+u32 AD5932_GetTriggerTime(void);
+#if AD5932_USE_PWM_CTRL
+s32 AD5932_StartPWMStepping(u08 timer, u32 dwell, u16 steps);
+s32 AD5932_StartPWMSteppingTable(u08 timer, const u32* dwellTable, u16 steps);
+void AD5932_StopPWMStepping(void);
+bool AD5932_PWMSteppingBusy(void);
+#endif
 
 #endif
@@ -0,0 +1,233 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_bank.c
+// @brief:      Multi-channel AD5932 bank, struct-of-arrays parameters and batch command word conversion
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+// --------------------------------------------------------------------------------------------------------------------
+// Includes
+// --------------------------------------------------------------------------------------------------------------------
+
+#include "main.h"
+#include "config.h"
+#if USE_AD5932
+
+#include "ad5932_bank.h"
+
+// --------------------------------------------------------------------------------------------------------------------
+// Notes
+// --------------------------------------------------------------------------------------------------------------------
+
+//The bank keeps every parameter in its own array, so the conversion runs one field at a time over all channels in
+//short loops, instead of converting AD5932Params_t structs one by one. The result is word-major as well: words[AD5932_BANK_FSTART_LO][0..count-1] and so on.
+//AD5932_BankSend() sends the words in the same order, so every chip gets its own sequence (control register first),
+//while the FSYNC of the chips is switched by the caller's chip select function.
+//All chips share the MCLK given to AD5932_Init() (and its calibration). The frequencies are converted with the inline
+//AD5932_FactorToWord(), and the envelope is checked on those words, so every frequency is converted once.
+//AD5932_BankSendParallel() programs more banks at once, each on its own SSP port. It does not wait for a word to finish
+//before starting the next one on the other port: one loop services every port, writes the next word when the port is
+//idle and closes FSYNC when the word is out, so the transfers overlap and the whole reconfiguration takes about as
+//long as the longest bank alone. The FSYNC has to go high after every 16 bit word, so one word is in flight per port;
+//DMA would not help that, the SSP FIFO is fed directly.
+//A port that does not finish a word within AD5932_BANK_POLLS rounds of the loop (SSP stopped, clock off) ends the
+//whole call with AD5932_PORT_BUSY, the FSYNC of the words in flight is released. The chips of the banks hold a partly
+//written sweep then, send the banks again.
+
+// --------------------------------------------------------------------------------------------------------------------
+// Functions
+// --------------------------------------------------------------------------------------------------------------------
+
+// ....................................................................................................................
+// @brief:      Converts the parameters of the whole bank to command words in one pass per field.
+//				Channels which are out of range or would pass MCLK/2 / wrap through zero (AD5932_ValidateSweepWords())
+//				are marked AD5932_BANK_INVALID.
+// @param[in]:  Bank, count and the parameter arrays filled
+// @return:     Number of invalid channels
+// ....................................................................................................................
+u16 AD5932_BankConvert(AD5932Bank_t* bank)
+{
+	u32 startWord[AD5932_BANK_SIZE], deltaWord[AD5932_BANK_SIZE];
+	u16 i, n = bank->count, invalid = 0;
+	u32 increment, mclk = AD5932_GetSweep()->mclk;
+	u64 factor = AD5932_GetFreqFactor();
+
+	if (n > AD5932_BANK_SIZE)
+		n = bank->count = AD5932_BANK_SIZE;
+
+	for (i = 0; i < n; i++)
+		startWord[i] = AD5932_FactorToWord(bank->startF[i], factor, mclk);
+	for (i = 0; i < n; i++)
+		deltaWord[i] = AD5932_FactorToWord(bank->deltaF[i], factor, mclk);
+
+	//control register, B0, B1, B4, B6, B7 and B11 always '1' (see AD5932_SetControlRegister())
+	for (i = 0; i < n; i++)
+		bank->words[AD5932_BANK_CREG][i] = AD5932_CREG | (bank->control & 0x0FFF) | 0x08D3;
+
+	for (i = 0; i < n; i++)
+	{
+		bank->words[AD5932_BANK_FSTART_LO][i] = AD5932_FSTART_LO | (startWord[i] & 0x0FFF);
+		bank->words[AD5932_BANK_FSTART_HI][i] = AD5932_FSTART_HI | ((startWord[i] >> 12) & 0x0FFF);
+	}
+
+	for (i = 0; i < n; i++)
+	{
+		bank->words[AD5932_BANK_DFREQ_LO][i] = AD5932_DFREQ_LO | (deltaWord[i] & 0x0FFF);
+		bank->words[AD5932_BANK_DFREQ_HI][i] = AD5932_DFREQ_HI | ((deltaWord[i] >> 12) & 0x07FF) |
+			((bank->flags[i] & AD5932_BANK_DECREMENTAL) ? 0x0800 : 0);
+	}
+
+	for (i = 0; i < n; i++)
+	{
+		bank->words[AD5932_BANK_TINT][i] = ((bank->flags[i] & AD5932_BANK_WAVE_BASED) ? AD5932_TINT_WCYCLES : AD5932_TINT_MCLKCYCLES) |
+			(bank->intervall[i] & 0x07FF);
+		bank->words[AD5932_BANK_NINCR][i] = AD5932_NINCR | (bank->increment[i] & 0x0FFF);
+	}
+
+	//range and envelope check, the same as a single sweep gets
+	for (i = 0; i < n; i++)
+	{
+		increment = bank->increment[i];
+		bank->flags[i] &= ~AD5932_BANK_INVALID;
+		if ((bank->intervall[i] < 2) || (bank->intervall[i] > 2047) ||
+			(AD5932_ValidateSweepWords(startWord[i], deltaWord[i], &increment,
+				(bank->flags[i] & AD5932_BANK_DECREMENTAL) ? DECREMENTAL_SWEEP : INCREMENTAL_SWEEP, false) != 0))
+		{
+			bank->flags[i] |= AD5932_BANK_INVALID;
+			invalid++;
+		}
+	}
+
+	return invalid;
+}
+
+// ....................................................................................................................
+// @brief:      Sends the converted bank to the chips on the SSP port set by AD5932_SetSPI(). Invalid channels are skipped.
+//				The sweeps are not started, trigger CTRL (common or per chip) after this.
+// @param[in]:  Bank converted by AD5932_BankConvert()
+// @param[in]:  FSYNC control, called with the channel index
+// @return:     0 if OK. Negative if there was an SPI error, 0xFFFF if SPI is busy, 0xFFF0 if there is no FSYNC control
+//				(NULL would send every channel to the driver's own chip).
+// ....................................................................................................................
+s32 AD5932_BankSend(const AD5932Bank_t* bank, AD5932_ChipSelect_t chipSelect)
+{
+	u16 i, w;
+	s32 ret;
+
+	if (chipSelect == NULL)
+		return AD5932_PARAM_ERROR;
+
+	for (w = 0; w < AD5932_BANK_WORDS; w++)
+	{
+		for (i = 0; i < bank->count; i++)
+		{
+			if (bank->flags[i] & AD5932_BANK_INVALID)
+				continue;
+			ret = AD5932_SendSPICommandCS(bank->words[w][i], chipSelect, i);
+			if (ret != 0)
+				return ret;
+		}
+	}
+	return 0;
+}
+
+// ....................................................................................................................
+// @brief:      Sends more converted banks at the same time, each on its own SSP port. Invalid channels are skipped.
+//				The sweeps are not started, trigger CTRL (common or per chip) after this.
+// @param[in]:  Banks with their ports, converted by AD5932_BankConvert(). Every port can be used only once.
+// @param[in]:  Number of banks, max. AD5932_BANK_BUSES
+// @return:     0 if OK. 0xFFFF if an SSP port is busy, 0xFFF0 if the parameters are wrong (a bank, port or FSYNC
+//				control is NULL, or a port is given twice).
+//				Nothing is sent then. 0xFFFF also if a word did not finish within AD5932_BANK_POLLS rounds, the banks
+//				are partly sent then.
+// ....................................................................................................................
+s32 AD5932_BankSendParallel(const AD5932BankBus_t* buses, u08 busCount)
+{
+	u16 chip[AD5932_BANK_BUSES];				//channel being sent per port
+	u08 word[AD5932_BANK_BUSES];				//command word index per port, AD5932_BANK_WORDS when done
+	bool inFlight[AD5932_BANK_BUSES];			//a word is on the wire, FSYNC is low
+	u32 polls[AD5932_BANK_BUSES];				//rounds the word in flight has been waited for
+	u08 b, i, active;
+
+	if ((busCount == 0) || (busCount > AD5932_BANK_BUSES))
+		return AD5932_PARAM_ERROR;
+	for (b = 0; b < busCount; b++)
+		if ((buses[b].bank == NULL) || (buses[b].ssp == NULL) || (buses[b].chipSelect == NULL))
+			return AD5932_PARAM_ERROR;
+
+	//two banks on one port would interleave their words on the same wire
+	for (b = 1; b < busCount; b++)
+		for (i = 0; i < b; i++)
+			if (buses[b].ssp == buses[i].ssp)
+				return AD5932_PARAM_ERROR;
+
+	for (b = 0; b < busCount; b++)
+	{
+		if (SSP_GetStatus(buses[b].ssp, SSP_STAT_BUSY) == SET)
+			return AD5932_PORT_BUSY;
+		for (i = 0; (i < 8) && (SSP_GetStatus(buses[b].ssp, SSP_STAT_RXFIFO_NOTEMPTY) == SET); i++)
+			SSP_ReceiveData(buses[b].ssp);		//leftovers of earlier transfers, the FIFO is 8 deep
+		chip[b] = 0;
+		word[b] = 0;
+		inFlight[b] = false;
+		polls[b] = 0;
+	}
+
+	do
+	{
+		active = 0;
+		for (b = 0; b < busCount; b++)
+		{
+			const AD5932Bank_t* bank = buses[b].bank;
+
+			if (inFlight[b])
+			{
+				//the word is out when the port is idle and its (dummy) answer arrived
+				if ((SSP_GetStatus(buses[b].ssp, SSP_STAT_BUSY) == SET) || (SSP_GetStatus(buses[b].ssp, SSP_STAT_RXFIFO_NOTEMPTY) != SET))
+				{
+					if (++polls[b] >= AD5932_BANK_POLLS)
+					{
+						for (i = 0; i < busCount; i++)
+							if (inFlight[i])
+								buses[i].chipSelect(chip[i], true);
+						return AD5932_PORT_BUSY;
+					}
+					active++;
+					continue;
+				}
+				SSP_ReceiveData(buses[b].ssp);
+				buses[b].chipSelect(chip[b], true);
+				inFlight[b] = false;
+				if (++chip[b] >= bank->count)
+				{
+					chip[b] = 0;
+					word[b]++;
+				}
+			}
+
+			//next valid channel, word-major as AD5932_BankSend()
+			while ((word[b] < AD5932_BANK_WORDS) && ((chip[b] >= bank->count) || (bank->flags[chip[b]] & AD5932_BANK_INVALID)))
+			{
+				if (++chip[b] >= bank->count)
+				{
+					chip[b] = 0;
+					word[b]++;
+				}
+			}
+			if (word[b] >= AD5932_BANK_WORDS)
+				continue;
+
+			buses[b].chipSelect(chip[b], false);
+			SSP_SendData(buses[b].ssp, bank->words[word[b]][chip[b]]);
+			inFlight[b] = true;
+			polls[b] = 0;
+			active++;
+		}
+	} while (active);
+
+	return 0;
+}
+
+#endif
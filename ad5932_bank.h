@@ -0,0 +1,70 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_bank.h
+// @brief:      Multi-channel AD5932 bank, struct-of-arrays parameters and batch command word conversion
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+#ifndef __AD5932_BANK_H
+#define __AD5932_BANK_H
+
+#include "defs.h"
+#include "ad5932.h"
+
+#ifndef AD5932_BANK_SIZE
+	#define AD5932_BANK_SIZE	64		//max. number of channels (chips) in a bank
+#endif
+
+//command words of one sweep, in programming order (control register first)
+typedef enum _AD5932_BankWord_t
+{
+	AD5932_BANK_CREG		= 0,
+	AD5932_BANK_FSTART_LO,
+	AD5932_BANK_FSTART_HI,
+	AD5932_BANK_DFREQ_LO,
+	AD5932_BANK_DFREQ_HI,
+	AD5932_BANK_TINT,
+	AD5932_BANK_NINCR,
+	AD5932_BANK_WORDS
+} AD5932_BankWord_t;
+
+#ifndef AD5932_BANK_BUSES
+	#define AD5932_BANK_BUSES	3		//max. number of SSP ports programmed in parallel
+#endif
+#ifndef AD5932_BANK_POLLS
+	#define AD5932_BANK_POLLS	100000	//rounds of AD5932_BankSendParallel() a word may take before the port is given up
+#endif
+
+//channel flags
+#define AD5932_BANK_WAVE_BASED	0x01	//WAVE_OUT_BASED increment interval, MCLK_INP_BASED otherwise
+#define AD5932_BANK_DECREMENTAL	0x02	//DECREMENTAL_SWEEP, INCREMENTAL_SWEEP otherwise
+#define AD5932_BANK_INVALID		0x80	//set by the conversion if the channel can not be programmed
+
+//parameters of all channels, one array per field
+typedef struct
+{
+	u16 count;									//number of used channels
+	u16 control;								//control register bits (D11-D0), common for the bank
+	u32 startF[AD5932_BANK_SIZE];				//start frequency in Hz
+	u32 deltaF[AD5932_BANK_SIZE];				//delta frequency in Hz
+	u16 increment[AD5932_BANK_SIZE];			//NINCR 2..4095
+	u16 intervall[AD5932_BANK_SIZE];			//TINT 2..2047
+	u08 flags[AD5932_BANK_SIZE];				//AD5932_BANK_xxx
+	u16 words[AD5932_BANK_WORDS][AD5932_BANK_SIZE];	//converted command words, word-major
+} AD5932Bank_t;
+
+//a bank bound to its own SSP port, for AD5932_BankSendParallel()
+typedef struct
+{
+	const AD5932Bank_t* bank;					//converted bank of the chips on this port
+	LPC_SSP_TypeDef* ssp;						//SSP port, configured with AD5932_ConfigSPI()
+	AD5932_ChipSelect_t chipSelect;				//FSYNC control of the chips on this port
+} AD5932BankBus_t;
+
+u16 AD5932_BankConvert(AD5932Bank_t* bank);
+s32 AD5932_BankSend(const AD5932Bank_t* bank, AD5932_ChipSelect_t chipSelect);
+s32 AD5932_BankSendParallel(const AD5932BankBus_t* buses, u08 busCount);
+
+#endif
@@ -0,0 +1,260 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_bus.c
+// @brief:      Priority based SSP (spi) bus arbiter for the AD5932 and the other chips on the same bus
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+// --------------------------------------------------------------------------------------------------------------------
+// Includes
+// --------------------------------------------------------------------------------------------------------------------
+
+#include "main.h"
+#include "config.h"
+#if USE_AD5932
+
+#include <string.h>
+#include "ad5932_bus.h"
+#include "ad5932_trace.h"
+
+// --------------------------------------------------------------------------------------------------------------------
+// Notes
+// --------------------------------------------------------------------------------------------------------------------
+
+//AD5932_SendSPICommand() only sees if the SSP is busy right now, so the words of a sweep program can be interleaved with
+//the traffic of other chips on the same bus. The arbiter works on transactions instead: a client calls
+//AD5932_BusBegin(), does all its transfers, then calls AD5932_BusEnd(). Nobody else gets the bus in between.
+//If the bus is taken, AD5932_BusBegin() returns AD5932_PORT_BUSY and marks the client as waiting; the client calls it
+//again later (main loop, next timer tick). When the bus is free, the waiting client with the highest priority gets it
+//first, equal priorities in order of arrival. A high priority client (ADC read) so never waits longer than the
+//current transaction, but it does not break into it either: preemption happens only between transactions.
+//Begin / End disable the interrupts for a few instructions only and restore the previous state (AD5932_CRITICAL_ENTER),
+//so they can be called from interrupts and other critical sections too. An interrupt must not wait for the bus in a
+//loop, it can not get it while the interrupted code holds it.
+//All clients of the bus have to use the arbiter, it does not guard the SSP itself.
+//Wait times are measured from the first refused AD5932_BusBegin() to the grant, with the time base of the bus.
+//A refused client has to call AD5932_BusBegin() again or AD5932_BusCancel(), a waiting mark blocks the less important
+//clients. With a time base, a waiting client that has not asked again for AD5932_BUS_STALE us is passed over and loses
+//its mark (its wait starts over at the next call), so a client that gave up silently does not lock the bus. Without a
+//time base the marks never expire: then every refused client must retry or cancel.
+
+// --------------------------------------------------------------------------------------------------------------------
+// Functions
+// --------------------------------------------------------------------------------------------------------------------
+
+// ....................................................................................................................
+// @brief:      Sets up a bus without clients
+// @param[in]:  LPC_SSP0 or LPC_SSP1
+// @param[in]:  Time base of the wait statistics, NULL if not needed
+// @return:     none
+// ....................................................................................................................
+void AD5932_BusInit(AD5932Bus_t* bus, LPC_SSP_TypeDef* SSPx, AD5932_TimeBase_t timeBase)
+{
+	memset(bus, 0, sizeof(*bus));
+	bus->ssp = SSPx;
+	bus->timeBase = timeBase;
+	bus->owner = AD5932_BUS_FREE;
+}
+
+// ....................................................................................................................
+// @brief:      Adds a client to the bus
+// @param[in]:  Priority, higher value wins
+// @return:     Client index, 0xFFF0 if the bus is full.
+// ....................................................................................................................
+s32 AD5932_BusRegister(AD5932Bus_t* bus, u08 priority)
+{
+	s32 ret = AD5932_PARAM_ERROR;
+	u32 primask;
+
+	AD5932_CRITICAL_ENTER(primask);
+	if (bus->clientCount < AD5932_BUS_CLIENTS)
+	{
+		ret = bus->clientCount++;
+		memset(&bus->client[ret], 0, sizeof(AD5932BusClient_t));
+		bus->client[ret].priority = priority;
+	}
+	AD5932_CRITICAL_EXIT(primask);
+	return ret;
+}
+
+// ....................................................................................................................
+// @brief:      Starts a transaction, takes the bus if it is free and no more important client waits for it
+// @param[in]:  Client index
+// @return:     0 if the bus is taken (or already owned by the client), 0xFFFF if busy - call it again later.
+//              0xFFF0 if the client is unknown.
+// ....................................................................................................................
+s32 AD5932_BusBegin(AD5932Bus_t* bus, u08 client)
+{
+	AD5932BusClient_t* me;
+	u32 now = 0;
+	u32 primask;
+	bool first;
+	u08 i;
+
+	if (client >= bus->clientCount)
+		return AD5932_PARAM_ERROR;
+	me = &bus->client[client];
+
+	if (bus->timeBase != NULL)
+		now = bus->timeBase();
+
+	AD5932_CRITICAL_ENTER(primask);
+	if (bus->owner == client)
+	{
+		AD5932_CRITICAL_EXIT(primask);
+		return 0;
+	}
+
+	first = !me->waiting;
+	if (first)
+	{
+		me->waiting = true;
+		me->waitStart = now;
+	}
+	me->waitPoll = now;
+
+	if (bus->owner != AD5932_BUS_FREE)
+	{
+		AD5932_CRITICAL_EXIT(primask);
+		if (first)
+			AD5932_TRACE_EVENT(AD5932_TR_BUS_WAIT, AD5932_TR_BEGIN, client);
+		return AD5932_PORT_BUSY;
+	}
+
+	//a more important waiting client, or the same priority waiting longer, goes first
+	for (i = 0; i < bus->clientCount; i++)
+	{
+		AD5932BusClient_t* other = &bus->client[i];
+
+		if ((i == client) || !other->waiting)
+			continue;
+		if ((bus->timeBase != NULL) && ((s32)(now - other->waitPoll) > AD5932_BUS_STALE))
+		{
+			//gave up without AD5932_BusCancel(); signed, as an interrupt may have polled after our time stamp
+			other->waiting = false;
+			AD5932_TRACE_EVENT(AD5932_TR_BUS_WAIT, AD5932_TR_END, i);
+			continue;
+		}
+		if ((other->priority > me->priority) ||
+			((other->priority == me->priority) && ((s32)(me->waitStart - other->waitStart) > 0)))
+		{
+			AD5932_CRITICAL_EXIT(primask);
+			if (first)
+				AD5932_TRACE_EVENT(AD5932_TR_BUS_WAIT, AD5932_TR_BEGIN, client);
+			return AD5932_PORT_BUSY;
+		}
+	}
+
+	bus->owner = client;
+	me->waiting = false;
+	AD5932_CRITICAL_EXIT(primask);
+
+	if (!first)
+		AD5932_TRACE_EVENT(AD5932_TR_BUS_WAIT, AD5932_TR_END, client);
+	me->waitLast = now - me->waitStart;
+	if (me->waitLast > me->waitMax)
+		me->waitMax = me->waitLast;
+	me->waitTotal += me->waitLast;
+	me->grants++;
+	return 0;
+}
+
+// ....................................................................................................................
+// @brief:      Closes a transaction, frees the bus
+// @param[in]:  Client index
+// @return:     0 if OK, 0xFFFF if the client was not the owner.
+// ....................................................................................................................
+s32 AD5932_BusEnd(AD5932Bus_t* bus, u08 client)
+{
+	s32 ret = AD5932_PORT_BUSY;
+	u32 primask;
+
+	AD5932_CRITICAL_ENTER(primask);
+	if (bus->owner == client)
+	{
+		bus->owner = AD5932_BUS_FREE;
+		ret = 0;
+	}
+	AD5932_CRITICAL_EXIT(primask);
+	return ret;
+}
+
+// ....................................................................................................................
+// @brief:      Withdraws a waiting request, if the client does not need the bus any more
+// @param[in]:  Client index
+// @return:     none
+// ....................................................................................................................
+void AD5932_BusCancel(AD5932Bus_t* bus, u08 client)
+{
+	bool waiting;
+	u32 primask;
+
+	if (client >= bus->clientCount)
+		return;
+
+	AD5932_CRITICAL_ENTER(primask);
+	waiting = bus->client[client].waiting;
+	bus->client[client].waiting = false;
+	AD5932_CRITICAL_EXIT(primask);
+
+	if (waiting)
+		AD5932_TRACE_EVENT(AD5932_TR_BUS_WAIT, AD5932_TR_END, client);
+}
+
+// ....................................................................................................................
+// @brief:      Clears the wait statistics of all clients
+// @param[in]:  none
+// @return:     none
+// ....................................................................................................................
+void AD5932_BusResetStats(AD5932Bus_t* bus)
+{
+	u08 i;
+
+	for (i = 0; i < bus->clientCount; i++)
+	{
+		bus->client[i].waitLast = 0;
+		bus->client[i].waitMax = 0;
+		bus->client[i].waitTotal = 0;
+		bus->client[i].grants = 0;
+	}
+}
+
+// ....................................................................................................................
+// @brief:      Programs a sweep in one transaction, so no foreign word gets between the words of it.
+//              The driver is switched to the SSP of the bus (AD5932_SetSPI()) for it, and stays there.
+//				Called inside the client's own transaction, the bus is left to the client; otherwise it is freed.
+// @param[in]:  Client index of the AD5932
+// @param[in]:  Sweep parameters
+// @param[in]:  SINE_OUT / TRIANGLE_OUT
+// @param[in]:  MSBOUT_EN / MSBOUT_DISABLE
+// @param[in]:  AUTOMATIC_TRIGGER / EXTERNAL_TRIGGER
+// @param[in]:  SYNCSEL_END / SYNCSEL_SUBSEQVENT
+// @param[in]:  SYNCOUT_EN / SYNCOUT_DISABLE
+// @return:     0xFFFF if the bus is busy - call it again later, otherwise as AD5932_SweepGenerator().
+// ....................................................................................................................
+s32 AD5932_BusSweep(AD5932Bus_t* bus, u08 client, const AD5932Params_t* params, RegBits_t WAVE_TYPE, RegBits_t MSBOUT, RegBits_t TRIGGER, RegBits_t SYNCSEL, RegBits_t SYNCOUT)
+{
+	s32 ret;
+	bool own;
+
+	//only the client can make itself the owner, so this does not change under us
+	own = (bus->owner != client);
+	if (own)
+	{
+		ret = AD5932_BusBegin(bus, client);
+		if (ret != 0)
+			return ret;
+	}
+
+	AD5932_SetSPI(bus->ssp);
+	ret = AD5932_SweepGenerator(params->startF, params->deltaF, params->increment, (AD5932_IncIntervall_t)params->incrementBase, params->intervall,
+								params->sweepType, WAVE_TYPE, MSBOUT, TRIGGER, SYNCSEL, SYNCOUT);
+
+	if (own)
+		AD5932_BusEnd(bus, client);
+	return ret;
+}
+
+#endif
@@ -0,0 +1,57 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_bus.h
+// @brief:      Priority based SSP (spi) bus arbiter for the AD5932 and the other chips on the same bus
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+#ifndef __AD5932_BUS_H
+#define __AD5932_BUS_H
+
+#include "defs.h"
+#include "ad5932.h"
+
+#ifndef AD5932_BUS_CLIENTS
+	#define AD5932_BUS_CLIENTS		8		//max. number of clients of one bus
+#endif
+
+#ifndef AD5932_BUS_STALE
+	#define AD5932_BUS_STALE		10000	//us, a waiting client that did not ask again for this long is passed over
+#endif
+
+#define AD5932_BUS_FREE			0xFF	//owner of a free bus
+
+//one bus client (AD5932, ADC, EEPROM...), with its arbitration wait statistics in time base units (us)
+typedef struct
+{
+	u08 priority;			//higher value wins
+	bool waiting;			//asked for the bus and did not get it yet
+	u32 waitStart;			//time of the first refused request
+	u32 waitPoll;			//time of the last refused request
+	u32 waitLast;			//wait of the last grant
+	u32 waitMax;			//longest wait
+	u64 waitTotal;			//sum of all waits
+	u32 grants;				//number of transactions
+} AD5932BusClient_t;
+
+//one SSP bus
+typedef struct
+{
+	LPC_SSP_TypeDef* ssp;		//SSP (spi) port of the bus, AD5932_BusSweep() sends on it
+	AD5932_TimeBase_t timeBase;
+	u08 clientCount;
+	volatile u08 owner;		//client index or AD5932_BUS_FREE
+	AD5932BusClient_t client[AD5932_BUS_CLIENTS];
+} AD5932Bus_t;
+
+void AD5932_BusInit(AD5932Bus_t* bus, LPC_SSP_TypeDef* SSPx, AD5932_TimeBase_t timeBase);
+s32 AD5932_BusRegister(AD5932Bus_t* bus, u08 priority);
+s32 AD5932_BusBegin(AD5932Bus_t* bus, u08 client);
+s32 AD5932_BusEnd(AD5932Bus_t* bus, u08 client);
+void AD5932_BusCancel(AD5932Bus_t* bus, u08 client);
+void AD5932_BusResetStats(AD5932Bus_t* bus);
+s32 AD5932_BusSweep(AD5932Bus_t* bus, u08 client, const AD5932Params_t* params, RegBits_t WAVE_TYPE, RegBits_t MSBOUT, RegBits_t TRIGGER, RegBits_t SYNCSEL, RegBits_t SYNCOUT);
+
+#endif
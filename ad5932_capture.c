@@ -0,0 +1,293 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_capture.c
+// @brief:      SYNCOUT synchronized, frequency tagged ADC capture for AD5932 sweeps
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+// --------------------------------------------------------------------------------------------------------------------
+// Includes
+// --------------------------------------------------------------------------------------------------------------------
+
+#include "main.h"
+#include "config.h"
+#if USE_AD5932
+
+#include <math.h>
+#include <string.h>
+#include "ad5932_capture.h"
+#include "ad5932_scan.h"
+#include "ad5932_trace.h"
+
+// --------------------------------------------------------------------------------------------------------------------
+// Defines
+// --------------------------------------------------------------------------------------------------------------------
+
+#define CAPTURE_FREE		0
+#define CAPTURE_FILLING		1
+#define CAPTURE_READY		2
+#define CAPTURE_2PI			6.28318531f
+#define CAPTURE_MAX_AMPLITUDE	2047		//synthetic sine stays within the 12 bit ADC range
+
+// --------------------------------------------------------------------------------------------------------------------
+// Variables
+// --------------------------------------------------------------------------------------------------------------------
+static AD5932CaptureBlock_t ad5932CaptureBlocks[2];
+static volatile u08 ad5932CaptureState[2];
+static volatile u32 ad5932CaptureEdges;
+static volatile u32 ad5932CaptureOverruns;
+static u08 ad5932CaptureFill;
+static u08 ad5932CaptureRead;
+static AD5932Sweep_t ad5932CaptureSweep;
+
+// --------------------------------------------------------------------------------------------------------------------
+// Notes
+// --------------------------------------------------------------------------------------------------------------------
+
+//With SYNCSEL_SUBSEQVENT and SYNCOUT_EN the SYNCOUT pin gives a 4 x TCLOCK pulse at each frequency increment.
+//Route it to a timer capture (or counter) input and call AD5932_CaptureSyncEdge() from its interrupt, or pass the
+//counter value to AD5932_CaptureSyncCount(). The ADC interrupt / DMA completion calls AD5932_CapturePush().
+//A block is closed when it is full or when the step changes, so every block belongs to exactly one frequency.
+//The two blocks are used as a double buffer: the producer fills one while the consumer processes the other.
+//If the consumer is late, the new samples are dropped and counted as overruns.
+//The blocks are tagged with the frequency of the programmed tuning words (AD5932_StepFrequency()), not the requested
+//one: DFREQ is truncated, so startF + step * deltaF drifts away from the output step by step.
+
+// --------------------------------------------------------------------------------------------------------------------
+// Functions
+// --------------------------------------------------------------------------------------------------------------------
+
+// ....................................................................................................................
+// @brief:      Opens the filling block for the given step. Drops the samples if both blocks are in use.
+// @param[in]:  Step index
+// @return:     true if there is a block to fill
+// ....................................................................................................................
+static bool AD5932_CaptureOpen(u32 step)
+{
+	AD5932CaptureBlock_t* block;
+
+	if (ad5932CaptureState[ad5932CaptureFill] == CAPTURE_FILLING)
+		return true;
+	if (ad5932CaptureState[ad5932CaptureFill] != CAPTURE_FREE)
+		return false;
+
+	block = &ad5932CaptureBlocks[ad5932CaptureFill];
+	block->step = step;
+	block->frequency = AD5932_StepFrequency(&ad5932CaptureSweep, step);
+	block->sampleCount = 0;
+	ad5932CaptureState[ad5932CaptureFill] = CAPTURE_FILLING;
+	return true;
+}
+
+// ....................................................................................................................
+// @brief:      Hands over the filling block to the consumer and switches to the other one.
+// @param[in]:  none
+// @return:     none
+// ....................................................................................................................
+static void AD5932_CaptureClose(void)
+{
+	if (ad5932CaptureState[ad5932CaptureFill] != CAPTURE_FILLING)
+		return;
+
+	if (ad5932CaptureBlocks[ad5932CaptureFill].sampleCount == 0)
+	{
+		ad5932CaptureState[ad5932CaptureFill] = CAPTURE_FREE;
+		return;
+	}
+
+	ad5932CaptureState[ad5932CaptureFill] = CAPTURE_READY;
+	ad5932CaptureFill ^= 1;
+}
+
+// ....................................................................................................................
+// @brief:      Resets the capture for a new sweep. Call it right before the CTRL trigger.
+// @param[in]:  The programmed sweep: AD5932_GetSweep(), or the sweep of an AD5932Dev_t
+// @return:     none
+// ....................................................................................................................
+void AD5932_CaptureStart(const AD5932Sweep_t* sweep)
+{
+	ad5932CaptureSweep = *sweep;
+	ad5932CaptureEdges = 0;
+	ad5932CaptureOverruns = 0;
+	ad5932CaptureFill = 0;
+	ad5932CaptureRead = 0;
+	ad5932CaptureState[0] = CAPTURE_FREE;
+	ad5932CaptureState[1] = CAPTURE_FREE;
+}
+
+// ....................................................................................................................
+// @brief:      SYNCOUT edge, call it from the timer capture interrupt.
+// @param[in]:  none
+// @return:     none
+// ....................................................................................................................
+void AD5932_CaptureSyncEdge(void)
+{
+	ad5932CaptureEdges++;
+	AD5932_TRACE_EVENT(AD5932_TR_SYNCOUT, AD5932_TR_INSTANT, (u16)ad5932CaptureEdges);
+}
+
+// ....................................................................................................................
+// @brief:      SYNCOUT edge count, if the edges are counted by a timer in counter mode.
+// @param[in]:  Number of SYNCOUT edges since the sweep start
+// @return:     none
+// ....................................................................................................................
+void AD5932_CaptureSyncCount(u32 edgeCount)
+{
+	if (edgeCount != ad5932CaptureEdges)
+		AD5932_TRACE_EVENT(AD5932_TR_SYNCOUT, AD5932_TR_INSTANT, (u16)edgeCount);
+	ad5932CaptureEdges = edgeCount;
+}
+
+// ....................................................................................................................
+// @brief:      Stores ADC samples, tagged with the active sweep step. Call it from the ADC interrupt / DMA completion.
+// @param[in]:  ADC samples
+// @param[in]:  Number of samples
+// @return:     none
+// ....................................................................................................................
+void AD5932_CapturePush(const u16* samples, u32 count)
+{
+	AD5932CaptureBlock_t* block;
+	u32 step = ad5932CaptureEdges;
+	u32 n;
+
+	while (count)
+	{
+		if (!AD5932_CaptureOpen(step))
+		{
+			ad5932CaptureOverruns += count;
+			return;
+		}
+
+		block = &ad5932CaptureBlocks[ad5932CaptureFill];
+		if ((block->step != step) && block->sampleCount)
+		{
+			AD5932_CaptureClose();
+			continue;
+		}
+		block->step = step;
+		block->frequency = AD5932_StepFrequency(&ad5932CaptureSweep, step);
+
+		n = AD5932_CAPTURE_BLOCK_SIZE - block->sampleCount;
+		if (n > count)
+			n = count;
+		memcpy(&block->samples[block->sampleCount], samples, n * sizeof(u16));
+		block->sampleCount += n;
+		samples += n;
+		count -= n;
+
+		if (block->sampleCount == AD5932_CAPTURE_BLOCK_SIZE)
+			AD5932_CaptureClose();
+	}
+}
+
+// ....................................................................................................................
+// @brief:      Hands over the partially filled block, ie. at the end of the sweep.
+// @param[in]:  none
+// @return:     none
+// ....................................................................................................................
+void AD5932_CaptureFlush(void)
+{
+	AD5932_CaptureClose();
+}
+
+// ....................................................................................................................
+// @brief:      Consumer side: gets the oldest ready block.
+// @param[in]:  none
+// @return:     The block, or NULL if there is nothing to process. Call AD5932_CaptureRelease() when done with it.
+// ....................................................................................................................
+const AD5932CaptureBlock_t* AD5932_CaptureGet(void)
+{
+	if (ad5932CaptureState[ad5932CaptureRead] != CAPTURE_READY)
+		return NULL;
+	return &ad5932CaptureBlocks[ad5932CaptureRead];
+}
+
+// ....................................................................................................................
+// @brief:      Consumer side: gives back the block got by AD5932_CaptureGet().
+// @param[in]:  none
+// @return:     none
+// ....................................................................................................................
+void AD5932_CaptureRelease(void)
+{
+	if (ad5932CaptureState[ad5932CaptureRead] != CAPTURE_READY)
+		return;
+	ad5932CaptureState[ad5932CaptureRead] = CAPTURE_FREE;
+	ad5932CaptureRead ^= 1;
+}
+
+// ....................................................................................................................
+// @brief:      Number of dropped samples since AD5932_CaptureStart()
+// @param[in]:  none
+// @return:     Dropped sample count
+// ....................................................................................................................
+u32 AD5932_CaptureOverruns(void)
+{
+	return ad5932CaptureOverruns;
+}
+
+// ....................................................................................................................
+// @brief:      Synthetic ADC / SYNCOUT source, to run the pipeline without hardware (ie. on the host).
+//				Generates a mid-scale centered sine at each step frequency, with a SYNCOUT edge every stepSamples.
+//				The ready blocks are passed to the consumer and released right after.
+// @param[in]:  The programmed sweep, as for AD5932_CaptureStart()
+// @param[in]:  ADC sample rate in Hz, nothing is generated if 0
+// @param[in]:  ADC samples per sweep step
+// @param[in]:  Sine amplitude in ADC codes (12 bit ADC, mid-scale is 2048), clamped to 2047
+// @param[in]:  Samples per AD5932_CapturePush() call, max. AD5932_CAPTURE_BLOCK_SIZE
+// @param[in]:  Block consumer
+// @return:     none
+// ....................................................................................................................
+void AD5932_CaptureSynthetic(const AD5932Sweep_t* sweep, u32 sampleRate, u32 stepSamples, u16 amplitude, u32 chunk, AD5932_CaptureConsumer_t consumer)
+{
+	u16 buffer[AD5932_CAPTURE_BLOCK_SIZE];
+	const AD5932CaptureBlock_t* block;
+	u32 step, sample, i, n;
+	float phase, phaseStep;
+
+	if ((sampleRate == 0) || (consumer == NULL))
+		return;
+	if ((chunk == 0) || (chunk > AD5932_CAPTURE_BLOCK_SIZE))
+		chunk = AD5932_CAPTURE_BLOCK_SIZE;
+	if (amplitude > CAPTURE_MAX_AMPLITUDE)
+		amplitude = CAPTURE_MAX_AMPLITUDE;
+
+	AD5932_CaptureStart(sweep);
+	phase = 0.0f;
+
+	for (step = 0; step <= sweep->increment; step++)
+	{
+		phaseStep = CAPTURE_2PI * (float)AD5932_StepFrequency(sweep, step) / (float)sampleRate;
+		for (sample = 0; sample < stepSamples; sample += n)
+		{
+			n = stepSamples - sample;
+			if (n > chunk)
+				n = chunk;
+			for (i = 0; i < n; i++)
+			{
+				buffer[i] = (u16)(2048.0f + amplitude * sinf(phase));
+				phase += phaseStep;
+				if (phase > CAPTURE_2PI)
+					phase -= CAPTURE_2PI;
+			}
+			AD5932_CapturePush(buffer, n);
+
+			while ((block = AD5932_CaptureGet()) != NULL)
+			{
+				consumer(block);
+				AD5932_CaptureRelease();
+			}
+		}
+		AD5932_CaptureSyncEdge();
+	}
+
+	AD5932_CaptureFlush();
+	while ((block = AD5932_CaptureGet()) != NULL)
+	{
+		consumer(block);
+		AD5932_CaptureRelease();
+	}
+}
+
+#endif
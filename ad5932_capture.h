@@ -0,0 +1,42 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_capture.h
+// @brief:      SYNCOUT synchronized, frequency tagged ADC capture for AD5932 sweeps
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+#ifndef __AD5932_CAPTURE_H
+#define __AD5932_CAPTURE_H
+
+#include "defs.h"
+#include "ad5932.h"
+
+#ifndef AD5932_CAPTURE_BLOCK_SIZE
+	#define AD5932_CAPTURE_BLOCK_SIZE	256		//ADC samples per block
+#endif
+
+//one block of ADC samples, all taken during the same sweep step
+typedef struct
+{
+	u16 step;				//sweep step index, 0 is the start frequency
+	u32 frequency;			//output frequency of the step in Hz, from the programmed tuning words
+	u32 sampleCount;		//valid samples in the block
+	u16 samples[AD5932_CAPTURE_BLOCK_SIZE];
+} AD5932CaptureBlock_t;
+
+//consumer of the ready blocks, used by the synthetic source
+typedef void (*AD5932_CaptureConsumer_t)(const AD5932CaptureBlock_t* block);
+
+void AD5932_CaptureStart(const AD5932Sweep_t* sweep);
+void AD5932_CaptureSyncEdge(void);
+void AD5932_CaptureSyncCount(u32 edgeCount);
+void AD5932_CapturePush(const u16* samples, u32 count);
+void AD5932_CaptureFlush(void);
+const AD5932CaptureBlock_t* AD5932_CaptureGet(void);
+void AD5932_CaptureRelease(void);
+u32 AD5932_CaptureOverruns(void);
+void AD5932_CaptureSynthetic(const AD5932Sweep_t* sweep, u32 sampleRate, u32 stepSamples, u16 amplitude, u32 chunk, AD5932_CaptureConsumer_t consumer);
+
+#endif
@@ -0,0 +1,273 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_demod.c
+// @brief:      Per sweep step Goertzel demodulator for AD5932 frequency response measurements
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+// --------------------------------------------------------------------------------------------------------------------
+// Includes
+// --------------------------------------------------------------------------------------------------------------------
+
+#include "main.h"
+#include "config.h"
+#if USE_AD5932
+
+#include <math.h>
+#include "ad5932_demod.h"
+
+// --------------------------------------------------------------------------------------------------------------------
+// Defines
+// --------------------------------------------------------------------------------------------------------------------
+
+#define DEMOD_2PI			6.28318531f
+#define DEMOD_COEFF_BITS	30				//Q30 coefficient, 2 * cos(w) < 2
+#define DEMOD_INPUT_BITS	8				//fraction bits of the samples in the fixed point state
+#define DEMOD_LIMIT			(1L << 28)		//the state is halved above this, 8x headroom for the next 4 samples
+#define DEMOD_MAX_SHIFT		24
+
+//one fixed point Goertzel step: x + coeff * a - b, with offset, shift and coeff of the caller
+//(the sample is scaled by a multiply, a left shift of the negative samples would be undefined)
+#define DEMOD_FIXED_STEP(x, a, b)	(((((s32)(x) - offset) * (1L << DEMOD_INPUT_BITS)) >> shift) + \
+									(s32)(((s64)coeff * (a) + (1L << (DEMOD_COEFF_BITS - 1))) >> DEMOD_COEFF_BITS) - (b))
+
+// --------------------------------------------------------------------------------------------------------------------
+// Variables
+// --------------------------------------------------------------------------------------------------------------------
+static AD5932_DemodOutput_t ad5932DemodOutput;
+static float ad5932DemodSampleRate;
+static float ad5932DemodOffset;
+static u32 ad5932DemodSettle;
+static bool ad5932DemodActive;
+static u16 ad5932DemodStep;
+static u32 ad5932DemodFrequency;
+static u32 ad5932DemodSkipped;
+static u32 ad5932DemodCount;
+#if AD5932_DEMOD_FIXED
+static s32 ad5932DemodCoeff;
+static s32 ad5932DemodS1;
+static s32 ad5932DemodS2;
+static u32 ad5932DemodShift;				//the state is scaled by 2^(DEMOD_INPUT_BITS - ad5932DemodShift)
+#else
+static float ad5932DemodCoeff;
+static float ad5932DemodS1;
+static float ad5932DemodS2;
+#endif
+
+// --------------------------------------------------------------------------------------------------------------------
+// Notes
+// --------------------------------------------------------------------------------------------------------------------
+
+//The blocks coming from ad5932_capture are already tagged with the sweep step and its frequency (start, delta and
+//NINCR are applied there), so the demodulator only has to run a Goertzel filter at the step frequency.
+//The state is carried over the blocks of the same step, so the result is the single bin DFT of the whole step
+//(minus the settle samples after each frequency increment). A step is finished by the first block of the next step,
+//or by AD5932_DemodFinish().
+//The Goertzel recursion is 1 multiply and 2 adds per sample, which is cheaper than an I/Q lock-in with a reference
+//oscillator, and the coefficient is calculated only once per step.
+//The SIMD kernel that was asked for is left out. The recursion is serial within a stream (s[n] needs s[n-1] and
+//s[n-2]), so lanes would have to be independent bins or steps, while a block holds one step at one frequency. And the
+//targets have nothing to run lanes on: the Cortex-M3 has no SIMD instructions at all, and the 16 bit dual MACs of a
+//Cortex-M4 do not fit the 32 bit state. The loops are only unrolled by 4, which saves the loop overhead, not work.
+//The Cortex-M3 parts (LPC175x / LPC177x) have no FPU, a float recursion would run in library calls there. They use
+//the fixed point kernel (AD5932_DEMOD_FIXED): Q30 coefficient, samples with 8 fraction bits, and a 32 bit state with
+//one SMULL per sample. The state is halved (and the samples shifted with it) when it comes near the 32 bit range,
+//so long steps and slow tones do not overflow, this is checked every 4 samples. Step frequencies have to stay above
+//sample rate / 4096 for the headroom of those 4 samples. Only the result of a step is calculated in float.
+//tools/ad5932_demodbench measures the throughput against the ADC rate and checks the amplitudes, of either kernel
+//(build it with -DAD5932_DEMOD_FIXED=1 for the fixed one). The margin of the target has to be measured there.
+
+// --------------------------------------------------------------------------------------------------------------------
+// Functions
+// --------------------------------------------------------------------------------------------------------------------
+
+// ....................................................................................................................
+// @brief:      Calculates the result of the running step and passes it to the output.
+// @param[in]:  none
+// @return:     none
+// ....................................................................................................................
+static void AD5932_DemodEmit(void)
+{
+	AD5932DemodResult_t result;
+	float w, re, im, c, s, s1, s2;
+
+	if (!ad5932DemodActive)
+		return;
+	ad5932DemodActive = false;
+
+	if (ad5932DemodCount == 0)
+		return;
+
+#if AD5932_DEMOD_FIXED
+	s1 = ldexpf((float)ad5932DemodS1, (int)ad5932DemodShift - DEMOD_INPUT_BITS);
+	s2 = ldexpf((float)ad5932DemodS2, (int)ad5932DemodShift - DEMOD_INPUT_BITS);
+#else
+	s1 = ad5932DemodS1;
+	s2 = ad5932DemodS2;
+#endif
+
+	//y = s1 - s2 * e^-jw, rotated back by w * (N - 1) to get the phase of the first sample
+	w = DEMOD_2PI * (float)ad5932DemodFrequency / ad5932DemodSampleRate;
+	re = s1 - s2 * cosf(w);
+	im = s2 * sinf(w);
+	c = cosf(w * (float)(ad5932DemodCount - 1));
+	s = sinf(w * (float)(ad5932DemodCount - 1));
+
+	result.step = ad5932DemodStep;
+	result.frequency = ad5932DemodFrequency;
+	result.sampleCount = ad5932DemodCount;
+	result.amplitude = 2.0f * sqrtf(re * re + im * im) / (float)ad5932DemodCount;
+	result.phase = atan2f(im * c - re * s, re * c + im * s) + DEMOD_2PI / 4.0f;		//cosine to sine reference
+	if (result.phase > DEMOD_2PI / 2.0f)
+		result.phase -= DEMOD_2PI;
+
+	ad5932DemodOutput(&result);
+}
+
+// ....................................................................................................................
+// @brief:      Resets the demodulator for a new sweep.
+// @param[in]:  ADC sample rate in Hz
+// @param[in]:  ADC offset (mid-scale code), removed from every sample
+// @param[in]:  Number of samples to skip after each frequency increment
+// @param[in]:  Output function, called once per finished step
+// @return:     none
+// ....................................................................................................................
+void AD5932_DemodStart(u32 sampleRate, u16 offset, u32 settle, AD5932_DemodOutput_t output)
+{
+	ad5932DemodSampleRate = (float)sampleRate;
+	ad5932DemodOffset = (float)offset;
+	ad5932DemodSettle = settle;
+	ad5932DemodOutput = output;
+	ad5932DemodActive = false;
+}
+
+// ....................................................................................................................
+// @brief:      Feeds one captured block into the demodulator.
+// @param[in]:  Block from AD5932_CaptureGet()
+// @return:     none
+// ....................................................................................................................
+void AD5932_DemodBlock(const AD5932CaptureBlock_t* block)
+{
+	const u16* x = block->samples;
+	u32 n = block->sampleCount;
+#if AD5932_DEMOD_FIXED
+	s32 s0, s1, s2, coeff, offset;
+	u32 shift;
+#else
+	float s0, s1, s2, coeff, offset;
+#endif
+
+	if (!ad5932DemodActive || (block->step != ad5932DemodStep))
+	{
+		AD5932_DemodEmit();
+
+		ad5932DemodActive = true;
+		ad5932DemodStep = block->step;
+		ad5932DemodFrequency = block->frequency;
+		ad5932DemodSkipped = 0;
+		ad5932DemodCount = 0;
+#if AD5932_DEMOD_FIXED
+		ad5932DemodCoeff = (s32)ldexpf(2.0f * cosf(DEMOD_2PI * (float)ad5932DemodFrequency / ad5932DemodSampleRate), DEMOD_COEFF_BITS);
+		ad5932DemodS1 = 0;
+		ad5932DemodS2 = 0;
+		ad5932DemodShift = 0;
+#else
+		ad5932DemodCoeff = 2.0f * cosf(DEMOD_2PI * (float)ad5932DemodFrequency / ad5932DemodSampleRate);
+		ad5932DemodS1 = 0.0f;
+		ad5932DemodS2 = 0.0f;
+#endif
+	}
+
+	if (ad5932DemodSkipped < ad5932DemodSettle)
+	{
+		u32 skip = ad5932DemodSettle - ad5932DemodSkipped;
+		if (skip > n)
+			skip = n;
+		ad5932DemodSkipped += skip;
+		x += skip;
+		n -= skip;
+	}
+
+	ad5932DemodCount += n;
+
+#if AD5932_DEMOD_FIXED
+	coeff = ad5932DemodCoeff;
+	offset = (s32)ad5932DemodOffset;
+	s1 = ad5932DemodS1;
+	s2 = ad5932DemodS2;
+	shift = ad5932DemodShift;
+
+	//unrolled by 4, the recursion itself is serial
+	while (n >= 4)
+	{
+		if ((s1 >= DEMOD_LIMIT) || (s1 <= -DEMOD_LIMIT) || (s2 >= DEMOD_LIMIT) || (s2 <= -DEMOD_LIMIT))
+		{
+			if (shift < DEMOD_MAX_SHIFT)
+			{
+				s1 >>= 1;
+				s2 >>= 1;
+				shift++;
+			}
+		}
+		s0 = DEMOD_FIXED_STEP(x[0], s1, s2);
+		s2 = DEMOD_FIXED_STEP(x[1], s0, s1);
+		s1 = DEMOD_FIXED_STEP(x[2], s2, s0);
+		s0 = DEMOD_FIXED_STEP(x[3], s1, s2);
+		s2 = s1;
+		s1 = s0;
+		x += 4;
+		n -= 4;
+	}
+	while (n--)
+	{
+		s0 = DEMOD_FIXED_STEP(*x++, s1, s2);
+		s2 = s1;
+		s1 = s0;
+	}
+
+	ad5932DemodS1 = s1;
+	ad5932DemodS2 = s2;
+	ad5932DemodShift = shift;
+#else
+	coeff = ad5932DemodCoeff;
+	offset = ad5932DemodOffset;
+	s1 = ad5932DemodS1;
+	s2 = ad5932DemodS2;
+
+	//unrolled by 4, the recursion itself is serial
+	while (n >= 4)
+	{
+		s0 = ((float)x[0] - offset) + coeff * s1 - s2;
+		s2 = ((float)x[1] - offset) + coeff * s0 - s1;
+		s1 = ((float)x[2] - offset) + coeff * s2 - s0;
+		s0 = ((float)x[3] - offset) + coeff * s1 - s2;
+		s2 = s1;
+		s1 = s0;
+		x += 4;
+		n -= 4;
+	}
+	while (n--)
+	{
+		s0 = ((float)*x++ - offset) + coeff * s1 - s2;
+		s2 = s1;
+		s1 = s0;
+	}
+
+	ad5932DemodS1 = s1;
+	ad5932DemodS2 = s2;
+#endif
+}
+
+// ....................................................................................................................
+// @brief:      Finishes the last step of the sweep.
+// @param[in]:  none
+// @return:     none
+// ....................................................................................................................
+void AD5932_DemodFinish(void)
+{
+	AD5932_DemodEmit();
+}
+
+#endif
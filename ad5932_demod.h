@@ -0,0 +1,43 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_demod.h
+// @brief:      Per sweep step Goertzel demodulator for AD5932 frequency response measurements
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+#ifndef __AD5932_DEMOD_H
+#define __AD5932_DEMOD_H
+
+#include "defs.h"
+#include "ad5932.h"
+#include "ad5932_capture.h"
+
+//fixed point Goertzel kernel for the parts without FPU, the float one for the others and the host
+#ifndef AD5932_DEMOD_FIXED
+	#if defined(MCU_FAMILY) && ((MCU_FAMILY == LPC175X6X) || (MCU_FAMILY == LPC177X8X_LPC407X8X))
+		#define AD5932_DEMOD_FIXED	1
+	#else
+		#define AD5932_DEMOD_FIXED	0
+	#endif
+#endif
+
+//amplitude and phase of one sweep step
+typedef struct
+{
+	u16 step;				//sweep step index
+	u32 frequency;			//output frequency of the step in Hz
+	u32 sampleCount;		//number of demodulated samples
+	float amplitude;		//in ADC codes
+	float phase;			//in radians, relative to the first demodulated sample of the step
+} AD5932DemodResult_t;
+
+//receives the result of every finished step
+typedef void (*AD5932_DemodOutput_t)(const AD5932DemodResult_t* result);
+
+void AD5932_DemodStart(u32 sampleRate, u16 offset, u32 settle, AD5932_DemodOutput_t output);
+void AD5932_DemodBlock(const AD5932CaptureBlock_t* block);
+void AD5932_DemodFinish(void);
+
+#endif
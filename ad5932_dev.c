@@ -0,0 +1,251 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_dev.c
+// @brief:      AD5932 device context with exclusive ownership, for more chips / buses
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+// --------------------------------------------------------------------------------------------------------------------
+// Includes
+// --------------------------------------------------------------------------------------------------------------------
+
+#include "main.h"
+#include "config.h"
+#if USE_AD5932
+
+#include <string.h>
+#include "ad5932_dev.h"
+#include "ad5932_plan.h"
+
+// --------------------------------------------------------------------------------------------------------------------
+// Notes
+// --------------------------------------------------------------------------------------------------------------------
+
+//The AD5932_xxx() functions of ad5932.c drive one chip through global state. An AD5932Dev_t holds everything of one
+//chip instead (bus, FSYNC, MCLK, programmed registers), so any number of them can live side by side, statically
+//allocated by the application.
+//A device has one owner at a time: AD5932_DevAcquire() takes it, AD5932_DevRelease() gives it back, and
+//AD5932_DevMove() hands it over without a free gap. Every call that touches the chip takes the owner token, and
+//returns AD5932_PORT_BUSY for anybody else, so two code paths can not program the same chip at once.
+//The owner token can be anything unique: the address of the task, driver or state machine using the chip.
+//CTRL is usually common for more chips, so the Dev functions do not trigger; use AD5932_TriggerCTRLPin() after them.
+//Limits: only FSYNC is bound per device. CTRL, INTERRUPT and STANDBY stay the global pins of ad5932.c (or the per
+//chip trigger of the application, see AD5932_SchedInit()). The ownership is cooperative: it guards the Dev functions
+//only. The global API (AD5932_SweepGenerator(), AD5932_SendSPICommand(), AD5932_SendSPICommandCS() ...) takes no
+//token, so a chip that is also reachable through it has to be left to its device owner by the application.
+
+// --------------------------------------------------------------------------------------------------------------------
+// Functions
+// --------------------------------------------------------------------------------------------------------------------
+
+// ....................................................................................................................
+// @brief:      Sets up a device context. The device is free after this.
+// @param[in]:  Device
+// @param[in]:  LPC_SSP0 or LPC_SSP1
+// @param[in]:  FSYNC control function
+// @param[in]:  Chip index passed to the FSYNC control
+// @param[in]:  External MCLK frequency in HZ
+// @return:     0 if OK, 0xFFF0 if MCLK is 0 or there is no FSYNC control. The device can not be acquired then.
+// ....................................................................................................................
+s32 AD5932_DevInit(AD5932Dev_t* dev, LPC_SSP_TypeDef* SSPx, AD5932_ChipSelect_t chipSelect, u08 chip, u32 MCLK)
+{
+	memset(dev, 0, sizeof(*dev));
+	if ((MCLK == 0) || (chipSelect == NULL))
+		return AD5932_PARAM_ERROR;
+
+	dev->ssp = SSPx;
+	dev->chipSelect = chipSelect;
+	dev->chip = chip;
+	dev->mclk = MCLK;
+	dev->freqFactor = ((u64)AD5932_ACCU_RESOLUTION << 32) / MCLK;
+	dev->sweep.mclk = MCLK;
+	chipSelect(chip, true);
+	return 0;
+}
+
+// ....................................................................................................................
+// @brief:      Takes the ownership of a free device.
+// @param[in]:  Device
+// @param[in]:  Owner token, not NULL
+// @return:     0 if OK (or already owned by the caller), 0xFFFF if somebody else owns it, 0xFFF0 if the owner is NULL
+//				or AD5932_DevInit() failed.
+// ....................................................................................................................
+s32 AD5932_DevAcquire(AD5932Dev_t* dev, const void* owner)
+{
+	s32 ret = AD5932_PORT_BUSY;
+	u32 primask;
+
+	if ((owner == NULL) || (dev->mclk == 0))
+		return AD5932_PARAM_ERROR;
+
+	AD5932_CRITICAL_ENTER(primask);
+	if ((dev->owner == NULL) || (dev->owner == owner))
+	{
+		dev->owner = owner;
+		ret = 0;
+	}
+	AD5932_CRITICAL_EXIT(primask);
+	return ret;
+}
+
+// ....................................................................................................................
+// @brief:      Gives back the ownership.
+// @param[in]:  Device
+// @param[in]:  Owner token
+// @return:     0 if OK, 0xFFFF if the caller is not the owner.
+// ....................................................................................................................
+s32 AD5932_DevRelease(AD5932Dev_t* dev, const void* owner)
+{
+	return AD5932_DevMove(dev, owner, NULL);
+}
+
+// ....................................................................................................................
+// @brief:      Hands over the ownership to a new owner, the device is never free in between.
+// @param[in]:  Device
+// @param[in]:  Owner token
+// @param[in]:  New owner token, NULL frees the device
+// @return:     0 if OK, 0xFFFF if the caller is not the owner.
+// ....................................................................................................................
+s32 AD5932_DevMove(AD5932Dev_t* dev, const void* owner, const void* newOwner)
+{
+	s32 ret = AD5932_PORT_BUSY;
+	u32 primask;
+
+	AD5932_CRITICAL_ENTER(primask);
+	if ((owner != NULL) && (dev->owner == owner))
+	{
+		dev->owner = newOwner;
+		ret = 0;
+	}
+	AD5932_CRITICAL_EXIT(primask);
+	return ret;
+}
+
+// ....................................................................................................................
+// @brief:      Sends one command word to the device, and keeps its register copy up to date.
+// @param[in]:  Device
+// @param[in]:  Owner token
+// @param[in]:  Command word
+// @return:     0 if OK. Negative if there was an SPI error, 0xFFFF if SPI is busy or the caller is not the owner.
+// ....................................................................................................................
+s32 AD5932_DevSend(AD5932Dev_t* dev, const void* owner, u16 commandWord)
+{
+	s32 ret;
+
+	if ((owner == NULL) || (dev->owner != owner))
+		return AD5932_PORT_BUSY;
+
+	ret = AD5932_SendSPICommandOn(dev->ssp, commandWord, dev->chipSelect, dev->chip);
+	if (ret == 0)
+		AD5932_DecodeCommand(commandWord, &dev->sweep, &dev->control);
+	return ret;
+}
+
+// ....................................................................................................................
+// @brief:      Converts a frequency to a tuning word with the MCLK of the device
+// @param[in]:  Device
+// @param[in]:  Frequency in Hz
+// @return:     Tuning word, AD5932_FactorToWord() with the MCLK of the device as AD5932_FrequencyToWord().
+// ....................................................................................................................
+u32 AD5932_DevFrequencyToWord(const AD5932Dev_t* dev, u32 value)
+{
+	return AD5932_FactorToWord(value, dev->freqFactor, dev->mclk);
+}
+
+// ....................................................................................................................
+// @brief:      Sends the control register and a 24 bit value in two words.
+// @param[in]:  Device
+// @param[in]:  Owner token
+// @param[in]:  Control register word
+// @param[in]:  Command of the low and high 12 bits (AD5932_FSTART_LO, AD5932_DFREQ_LO)
+// @param[in]:  24 bit value
+// @return:     0 if OK, SPI / ownership error otherwise.
+// ....................................................................................................................
+static s32 AD5932_DevSend24(AD5932Dev_t* dev, const void* owner, u16 loCommand, u32 value)
+{
+	s32 ret;
+
+	ret = AD5932_DevSend(dev, owner, loCommand | (value & 0x0FFF));
+	if (ret != 0)
+		return ret;
+	return AD5932_DevSend(dev, owner, (loCommand + (AD5932_DFREQ_HI - AD5932_DFREQ_LO)) | ((value >> 12) & 0x0FFF));
+}
+
+// ....................................................................................................................
+// @brief:      Programs the device as a simple DDS. Trigger CTRL to start the output.
+// @param[in]:  Device
+// @param[in]:  Owner token
+// @param[in]:  Frequency in Hz
+// @param[in]:  SINE_OUT / TRIANGLE_OUT
+// @param[in]:  MSBOUT_EN / MSBOUT_DISABLE
+// @return:     0 if all is OK, negative value if not, 0xFFFF if the caller is not the owner.
+// ....................................................................................................................
+s32 AD5932_DevSingleFrequency(AD5932Dev_t* dev, const void* owner, u32 frequency, RegBits_t WAVE_TYPE, RegBits_t MSBOUT)
+{
+	u16 control = AD5932_PlanControlWord(WAVE_TYPE, MSBOUT, EXTERNAL_TRIGGER, SYNCSEL_END, SYNCOUT_EN);
+	s32 ret;
+
+	ret = AD5932_DevSend(dev, owner, control);
+	if (ret == AD5932_PORT_BUSY)
+		return ret;
+	if (ret != 0)
+		return -1;
+
+	if (AD5932_DevSend24(dev, owner, AD5932_FSTART_LO, AD5932_DevFrequencyToWord(dev, frequency)) != 0)
+		return -2;
+	return 0;
+}
+
+// ....................................................................................................................
+// @brief:      Programs a sweep into the device. Trigger CTRL to start it.
+// @param[in]:  Device
+// @param[in]:  Owner token
+// @param[in]:  Sweep parameters
+// @param[in]:  SINE_OUT / TRIANGLE_OUT
+// @param[in]:  MSBOUT_EN / MSBOUT_DISABLE
+// @param[in]:  AUTOMATIC_TRIGGER / EXTERNAL_TRIGGER
+// @param[in]:  SYNCSEL_END / SYNCSEL_SUBSEQVENT
+// @param[in]:  SYNCOUT_EN / SYNCOUT_DISABLE
+// @return:     0 if all is OK, negative value if not (same codes as AD5932_SweepGenerator()), 0xFFFF if the caller is not the owner.
+// ....................................................................................................................
+s32 AD5932_DevSweep(AD5932Dev_t* dev, const void* owner, const AD5932Params_t* params, RegBits_t WAVE_TYPE, RegBits_t MSBOUT, RegBits_t TRIGGER, RegBits_t SYNCSEL, RegBits_t SYNCOUT)
+{
+	u16 control = AD5932_PlanControlWord(WAVE_TYPE, MSBOUT, TRIGGER, SYNCSEL, SYNCOUT);
+	u32 startWord, deltaWord, increment = params->increment;
+	s32 ret;
+
+	if ((params->intervall < 2) || (params->intervall > 2047))
+		return -6;
+
+	//the envelope check of AD5932_ValidateSweep(), with the MCLK of the device
+	startWord = AD5932_DevFrequencyToWord(dev, params->startF);
+	deltaWord = AD5932_DevFrequencyToWord(dev, params->deltaF);
+	if (AD5932_ValidateSweepWords(startWord, deltaWord, &increment, (AD5932_SweepType_t)params->sweepType, false) != 0)
+		return -6;
+
+	ret = AD5932_DevSend(dev, owner, control);
+	if (ret == AD5932_PORT_BUSY)
+		return ret;
+	if (ret != 0)
+		return -1;
+
+	if (AD5932_DevSend24(dev, owner, AD5932_FSTART_LO, startWord) != 0)
+		return -2;
+
+	if (params->sweepType == DECREMENTAL_SWEEP)
+		deltaWord |= 0x00800000;		//negative sweep indicator bit
+	if (AD5932_DevSend24(dev, owner, AD5932_DFREQ_LO, deltaWord) != 0)
+		return -3;
+
+	if (AD5932_DevSend(dev, owner, ((params->incrementBase == WAVE_OUT_BASED) ? AD5932_TINT_WCYCLES : AD5932_TINT_MCLKCYCLES) | params->intervall) != 0)
+		return -4;
+
+	if (AD5932_DevSend(dev, owner, AD5932_NINCR | params->increment) != 0)
+		return -5;
+
+	return 0;
+}
+
+#endif
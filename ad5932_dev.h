@@ -0,0 +1,38 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_dev.h
+// @brief:      AD5932 device context with exclusive ownership, for more chips / buses
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+#ifndef __AD5932_DEV_H
+#define __AD5932_DEV_H
+
+#include "defs.h"
+#include "ad5932.h"
+
+//one AD5932 chip: bus, FSYNC binding, MCLK and the programmed registers. CTRL, INT and STDBY are the global pins.
+typedef struct
+{
+	LPC_SSP_TypeDef* ssp;				//SSP (spi) port of the chip
+	AD5932_ChipSelect_t chipSelect;		//FSYNC control
+	u08 chip;							//chip index passed to the FSYNC control
+	u32 mclk;							//MCLK in Hz
+	u64 freqFactor;						//2^56 / MCLK, see AD5932_SetMCLKCorrection()
+	const void* owner;					//owner token, NULL if free
+	u16 control;						//last control register word
+	AD5932Sweep_t sweep;				//programmed sweep
+} AD5932Dev_t;
+
+s32 AD5932_DevInit(AD5932Dev_t* dev, LPC_SSP_TypeDef* SSPx, AD5932_ChipSelect_t chipSelect, u08 chip, u32 MCLK);
+s32 AD5932_DevAcquire(AD5932Dev_t* dev, const void* owner);
+s32 AD5932_DevRelease(AD5932Dev_t* dev, const void* owner);
+s32 AD5932_DevMove(AD5932Dev_t* dev, const void* owner, const void* newOwner);
+s32 AD5932_DevSend(AD5932Dev_t* dev, const void* owner, u16 commandWord);
+u32 AD5932_DevFrequencyToWord(const AD5932Dev_t* dev, u32 value);
+s32 AD5932_DevSingleFrequency(AD5932Dev_t* dev, const void* owner, u32 frequency, RegBits_t WAVE_TYPE, RegBits_t MSBOUT);
+s32 AD5932_DevSweep(AD5932Dev_t* dev, const void* owner, const AD5932Params_t* params, RegBits_t WAVE_TYPE, RegBits_t MSBOUT, RegBits_t TRIGGER, RegBits_t SYNCSEL, RegBits_t SYNCOUT);
+
+#endif
@@ -0,0 +1,125 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_lib.c
+// @brief:      Precompiled AD5932 sweep library, executed in place from flash
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+// --------------------------------------------------------------------------------------------------------------------
+// Includes
+// --------------------------------------------------------------------------------------------------------------------
+
+#include "main.h"
+#include "config.h"
+#if USE_AD5932
+
+#include "ad5932_lib.h"
+
+// --------------------------------------------------------------------------------------------------------------------
+// Notes
+// --------------------------------------------------------------------------------------------------------------------
+
+//The library is generated offline by tools/ad5932_mklib from a plan description, and linked / flashed as a const blob.
+//Every entry holds the finished command words, so running a sweep is only the SPI writes and the CTRL trigger:
+//nothing is converted or planned at boot. The same accessors work on the host on an mmap()-ed library file.
+//Check the library once with AD5932_LibCheck() (magic, version, size, checksum and MCLK) before running it.
+//The words are not corrected for the MCLK error, see ad5932_lib.h.
+
+// --------------------------------------------------------------------------------------------------------------------
+// Functions
+// --------------------------------------------------------------------------------------------------------------------
+
+// ....................................................................................................................
+// @brief:      FNV-1a checksum
+// @param[in]:  Data
+// @param[in]:  Size in bytes
+// @return:     Checksum
+// ....................................................................................................................
+u32 AD5932_LibChecksum(const void* data, u32 size)
+{
+	const u08* p = (const u08*)data;
+	uint32_t h = 2166136261u;			//32 bit wrap on the host too
+
+	while (size--)
+		h = (h ^ *p++) * 16777619u;
+	return h;
+}
+
+// ....................................................................................................................
+// @brief:      Validates a library image
+// @param[in]:  Library image
+// @param[in]:  Image size in bytes
+// @param[in]:  MCLK in Hz the sweeps must be calculated for, 0 to skip the check
+// @return:     0 if OK, 0xFFF0 if the image is invalid or does not match.
+// ....................................................................................................................
+s32 AD5932_LibCheck(const void* lib, u32 size, u32 mclk)
+{
+	const AD5932LibHeader_t* header = (const AD5932LibHeader_t*)lib;
+	u32 payload;
+
+	if ((lib == NULL) || (size < sizeof(AD5932LibHeader_t)))
+		return AD5932_PARAM_ERROR;
+	if ((header->magic != AD5932_LIB_MAGIC) || (header->version != AD5932_LIB_VERSION))
+		return AD5932_PARAM_ERROR;
+
+	payload = (u32)header->count * sizeof(AD5932LibSweep_t);
+	if (size < sizeof(AD5932LibHeader_t) + payload)
+		return AD5932_PARAM_ERROR;
+	if ((mclk != 0) && (header->mclk != mclk))
+		return AD5932_PARAM_ERROR;
+	if (AD5932_LibChecksum(header + 1, payload) != header->checksum)
+		return AD5932_PARAM_ERROR;
+
+	return 0;
+}
+
+// ....................................................................................................................
+// @brief:      Gets a sweep entry in place
+// @param[in]:  Library image, checked by AD5932_LibCheck()
+// @param[in]:  Sweep index
+// @return:     The entry, NULL if the index is out of range.
+// ....................................................................................................................
+const AD5932LibSweep_t* AD5932_LibGet(const void* lib, u16 index)
+{
+	const AD5932LibHeader_t* header = (const AD5932LibHeader_t*)lib;
+
+	if (index >= header->count)
+		return NULL;
+	return (const AD5932LibSweep_t*)(header + 1) + index;
+}
+
+// ....................................................................................................................
+// @brief:      Programs a library sweep and starts it if its control word has AUTOMATIC_TRIGGER.
+// @param[in]:  Library image, checked by AD5932_LibCheck()
+// @param[in]:  Sweep index
+// @return:     0 if all is OK, 0xFFF0 for a wrong index, negative value if the SPI write failed.
+// ....................................................................................................................
+s32 AD5932_LibRun(const void* lib, u16 index)
+{
+	const AD5932LibSweep_t* sweep = AD5932_LibGet(lib, index);
+	u16 i;
+
+	if (sweep == NULL)
+		return AD5932_PARAM_ERROR;
+
+	AD5932_SetCTRLPin(false);
+	if (AD5932_SendSPICommand(sweep->control) != 0)
+		return -1;
+
+	for (i = 0; i < AD5932_PLAN_WORDS; i++)
+	{
+		if (AD5932_SendSPICommand(sweep->words[i]) != 0)
+			return -2;
+	}
+
+	//the trigger saves the shadow too
+	if (((sweep->control >> 5) & 1) == AUTOMATIC_TRIGGER)
+		AD5932_TriggerCTRLPin();
+	else
+		AD5932_SaveShadow();
+	return 0;
+}
+
+#endif
@@ -0,0 +1,54 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_lib.h
+// @brief:      Precompiled AD5932 sweep library, executed in place from flash
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+#ifndef __AD5932_LIB_H
+#define __AD5932_LIB_H
+
+#include <stdint.h>
+#include "defs.h"
+#include "ad5932.h"
+#include "ad5932_plan.h"
+
+#define AD5932_LIB_MAGIC		0x39354441		//"AD59", little endian
+#define AD5932_LIB_VERSION		1
+
+//Precompiled sweeps are uncorrected: the tuning words are calculated offline for the MCLK in the header, so the ppb
+//correction (AD5932_SetMCLKCorrection(), AD5932_CalibrateMCLK()) and the temperature table (AD5932_SetTempTable())
+//of the live path do not apply to them. To run a library on a calibrated MCLK, build it for the corrected MCLK and
+//check it against AD5932_GetSweep()->mclk. With a temperature table in use, plan the sweeps at run time instead.
+//The on-flash format has fixed width fields, the same on the target and on the host (where u32 may be 64 bit wide).
+//library header, followed by count AD5932LibSweep_t entries. Little endian, 8 byte aligned.
+typedef struct
+{
+	uint32_t magic;			//AD5932_LIB_MAGIC
+	uint16_t version;		//AD5932_LIB_VERSION
+	uint16_t count;			//number of sweeps
+	uint32_t mclk;			//MCLK the tuning words were calculated for, in Hz
+	uint32_t checksum;		//FNV-1a of the sweep entries
+} AD5932LibHeader_t;
+
+//one ready-to-send sweep
+typedef struct
+{
+	uint16_t control;					//control register word
+	uint16_t words[AD5932_PLAN_WORDS];	//FSTART, DFREQ, TINT, NINCR words in sending order
+	uint16_t reserved;
+	uint64_t duration;					//sweep duration in ns
+} AD5932LibSweep_t;
+
+//compile time size checks of the format: the build fails on a negative array size
+typedef char AD5932LibHeaderSize_t[(sizeof(AD5932LibHeader_t) == 16) ? 1 : -1];
+typedef char AD5932LibSweepSize_t[(sizeof(AD5932LibSweep_t) == 24) ? 1 : -1];
+
+u32 AD5932_LibChecksum(const void* data, u32 size);
+s32 AD5932_LibCheck(const void* lib, u32 size, u32 mclk);
+const AD5932LibSweep_t* AD5932_LibGet(const void* lib, u16 index);
+s32 AD5932_LibRun(const void* lib, u16 index);
+
+#endif
@@ -0,0 +1,551 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_plan.c
+// @brief:      Sweep planner (start / stop / duration to AD5932 register words) with a memoization cache
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+// --------------------------------------------------------------------------------------------------------------------
+// Includes
+// --------------------------------------------------------------------------------------------------------------------
+
+#include "main.h"
+#include "config.h"
+#if USE_AD5932
+
+#include "ad5932_plan.h"
+
+// --------------------------------------------------------------------------------------------------------------------
+// Defines
+// --------------------------------------------------------------------------------------------------------------------
+
+#define PLAN_MAX_CYCLES		((u64)2048 * 4096)		//longer than any TINT * (NINCR + 1), even rounded
+
+// --------------------------------------------------------------------------------------------------------------------
+// Types
+// --------------------------------------------------------------------------------------------------------------------
+
+typedef struct
+{
+	bool valid;
+	u32 startF;
+	u32 stopF;
+	u64 duration;
+	u32 mclk;
+	AD5932Plan_t plan;
+} AD5932PlanEntry_t;
+
+// --------------------------------------------------------------------------------------------------------------------
+// Variables
+// --------------------------------------------------------------------------------------------------------------------
+static AD5932PlanEntry_t ad5932PlanCache[AD5932_PLAN_CACHE_SIZE];
+static u08 ad5932PlanCacheVictim;
+static u32 ad5932PlanCacheHits;
+static u32 ad5932PlanCacheMisses;
+
+// --------------------------------------------------------------------------------------------------------------------
+// Notes
+// --------------------------------------------------------------------------------------------------------------------
+
+//The planner searches every NINCR (2..4095) for an MCLK based sweep from startF to stopF in the given time:
+//the DFREQ word is the rounded (stop - start) / NINCR, and TINT the rounded duration / (NINCR + 1) MCLK periods.
+//The best plan has the smallest relative end frequency + duration error, more steps win on a tie.
+//This is a few thousand 64 bit divisions, so the results are kept in a small cache, indexed by the hash of the
+//request and probed linearly for AD5932_PLAN_CACHE_PROBE entries. A miss replaces the probed entries round-robin.
+//AD5932_PlanFit() covers any f(t) profile with consecutive MCLK based sweeps. A segment is a staircase: NINCR + 1
+//steps of TINT periods. Its steps are put on the line through the profile at the centre of the first and last
+//step, so the staircase is never further from that line than half a DFREQ. The segment error is the largest
+//distance of the line from the profile at AD5932_FIT_CHECKS points, plus that half step, plus 1/8 of the largest
+//second difference of the samples for the bend of the profile between two points, and it has to stay in the
+//frequency budget. A step is never longer than the timing budget, so every frequency is reached within that time of
+//its place in the profile. NINCR is as high as possible (finest steps), TINT is rounded down, and the next segment
+//starts where the previous one really ended, so the rounding does not add up.
+//Each segment is made as long as possible (the error is expected to grow with the length): the search starts from the
+//length of the previous segment, doubles / halves it to bracket the longest fitting one, and narrows the bracket to
+//1/64 of the length, so the number of segments is close to the least. A segment costs a few (typically 5-10) tries of
+//AD5932_FIT_CHECKS profile calls: a 10 s profile is fitted in milliseconds on a PC, short profiles are fine on the MCU.
+//The output holds the frequency of the last step until the next segment is programmed and triggered at its start.
+//The next segment can only be sent after the previous one ended: the control register write of AD5932_SendPlan()
+//resets the state machine (the output goes to midscale) and the CTRL pulse starts the new sweep. So every segment
+//boundary is a gap of the reprogramming time, the next segment starts that much later in the profile. The gap has to
+//be within the timing budget, and no segment but the last one is shorter than the gap (the output would be off the
+//profile more than on it). If the profile can not be covered so, the fit fails.
+
+// --------------------------------------------------------------------------------------------------------------------
+// Functions
+// --------------------------------------------------------------------------------------------------------------------
+
+// ....................................................................................................................
+// @brief:      Converts a time to MCLK periods, rounded. The product is split at whole seconds, so it does not overflow.
+// @param[in]:  Time in ns
+// @param[in]:  MCLK frequency in Hz, not 0
+// @return:     MCLK periods, saturated to (u64)-1 (times over ~68 years at 4GHz)
+// ....................................................................................................................
+static u64 AD5932_PlanCycles(u64 time, u32 mclk)
+{
+	if (time / 1000000000 >= ((u64)-1 >> 1) / mclk)
+		return (u64)-1;
+	return (time / 1000000000) * mclk + ((time % 1000000000) * mclk + 500000000) / 1000000000;
+}
+
+// ....................................................................................................................
+// @brief:      Converts MCLK periods to a time, truncated. Split at whole seconds as AD5932_PlanCycles().
+// @param[in]:  MCLK periods
+// @param[in]:  MCLK frequency in Hz, not 0
+// @return:     Time in ns
+// ....................................................................................................................
+static u64 AD5932_PlanTime(u64 cycles, u32 mclk)
+{
+	return (cycles / mclk) * 1000000000 + ((cycles % mclk) * 1000000000) / mclk;
+}
+
+// ....................................................................................................................
+// @brief:      Plans an MCLK based sweep from startF to stopF, lasting duration.
+// @param[in]:  Start frequency in Hz
+// @param[in]:  Stop frequency in Hz, lower than the start frequency for a decremental sweep
+// @param[in]:  Sweep duration in ns
+// @param[in]:  MCLK frequency in Hz
+// @param[out]: The plan
+// @return:     0 if OK, 0xFFF0 if no plan is possible (Nyquist, too short / long duration, MCLK is 0).
+// ....................................................................................................................
+s32 AD5932_PlanSweep(u32 startF, u32 stopF, u64 duration, u32 mclk, AD5932Plan_t* plan)
+{
+	u32 startWord, stopWord, span, deltaWord, endWord, nincr, tint, bestNincr = 0, bestTint = 0, bestDelta = 0;
+	u64 cycles, reached, durationError, endError, cost, bestCost = (u64)-1;
+	bool decremental;
+
+	if ((mclk == 0) || (startF >= mclk / 2) || (stopF >= mclk / 2))
+		return AD5932_PARAM_ERROR;
+
+	startWord = ((u64)startF * AD5932_ACCU_RESOLUTION + mclk / 2) / mclk;
+	stopWord = ((u64)stopF * AD5932_ACCU_RESOLUTION + mclk / 2) / mclk;
+	if (startWord == 0)
+		return AD5932_PARAM_ERROR;
+	decremental = stopWord < startWord;
+	span = decremental ? startWord - stopWord : stopWord - startWord;
+
+	cycles = AD5932_PlanCycles(duration, mclk);
+	if (cycles >= PLAN_MAX_CYCLES)
+		return AD5932_PARAM_ERROR;
+
+	for (nincr = 2; nincr <= 4095; nincr++)
+	{
+		tint = (u32)((cycles + (nincr + 1) / 2) / (nincr + 1));
+		if ((tint < 2) || (tint > 2047))
+			continue;
+
+		deltaWord = (span + nincr / 2) / nincr;
+		if (deltaWord >= AD5932_NYQUIST_WORD)
+			continue;
+		if (decremental)
+		{
+			if ((u64)deltaWord * nincr >= startWord)
+				continue;
+			endWord = startWord - deltaWord * nincr;
+		}
+		else
+		{
+			if ((u64)startWord + (u64)deltaWord * nincr >= AD5932_NYQUIST_WORD)
+				continue;
+			endWord = startWord + deltaWord * nincr;
+		}
+
+		//relative errors in 2^-32 units, so frequency and time are comparable
+		reached = (u64)tint * (nincr + 1);
+		durationError = (reached > cycles) ? reached - cycles : cycles - reached;
+		endError = (endWord > stopWord) ? endWord - stopWord : stopWord - endWord;
+		cost = (cycles ? (durationError << 32) / cycles : 0) + (span ? ((u64)endError << 32) / span : 0);
+
+		if (cost <= bestCost)
+		{
+			bestCost = cost;
+			bestNincr = nincr;
+			bestTint = tint;
+			bestDelta = deltaWord;
+		}
+	}
+
+	if (bestNincr == 0)
+		return AD5932_PARAM_ERROR;
+
+	endWord = decremental ? startWord - bestDelta * bestNincr : startWord + bestDelta * bestNincr;
+	reached = ((u64)bestTint * (bestNincr + 1) * 1000000000 + mclk / 2) / mclk;
+
+	plan->words[AD5932_PLAN_FSTART_LO] = AD5932_FSTART_LO | (startWord & 0x0FFF);
+	plan->words[AD5932_PLAN_FSTART_HI] = AD5932_FSTART_HI | ((startWord >> 12) & 0x0FFF);
+	plan->words[AD5932_PLAN_DFREQ_LO] = AD5932_DFREQ_LO | (bestDelta & 0x0FFF);
+	plan->words[AD5932_PLAN_DFREQ_HI] = AD5932_DFREQ_HI | ((bestDelta >> 12) & 0x07FF) | (decremental ? 0x0800 : 0);
+	plan->words[AD5932_PLAN_TINT] = AD5932_TINT_MCLKCYCLES | bestTint;
+	plan->words[AD5932_PLAN_NINCR] = AD5932_NINCR | bestNincr;
+	plan->endError = (u32)((((endWord > stopWord) ? endWord - stopWord : stopWord - endWord) * (u64)mclk) >> 24);
+	plan->durationError = (u32)((reached > duration) ? reached - duration : duration - reached);
+	return 0;
+}
+
+// ....................................................................................................................
+// @brief:      Sends the register words of a plan. Set the control register first, and trigger CTRL after this.
+// @param[in]:  The plan
+// @return:     0 if OK. Negative if there was an SPI error, 0xFFFF if SPI is busy.
+// ....................................................................................................................
+s32 AD5932_SendPlan(const AD5932Plan_t* plan)
+{
+	u16 i;
+	s32 ret;
+
+	for (i = 0; i < AD5932_PLAN_WORDS; i++)
+	{
+		ret = AD5932_SendSPICommand(plan->words[i]);
+		if (ret != 0)
+			return ret;
+	}
+	AD5932_SaveShadow();
+	return 0;
+}
+
+// ....................................................................................................................
+// @brief:      Control register word with the DAC enabled, same bits as AD5932_SetControlRegister() sends.
+// @param[in]:  SINE_OUT / TRIANGLE_OUT
+// @param[in]:  MSBOUT_EN / MSBOUT_DISABLE
+// @param[in]:  AUTOMATIC_TRIGGER / EXTERNAL_TRIGGER
+// @param[in]:  SYNCSEL_END / SYNCSEL_SUBSEQVENT
+// @param[in]:  SYNCOUT_EN / SYNCOUT_DISABLE
+// @return:     Control register command word
+// ....................................................................................................................
+u16 AD5932_PlanControlWord(RegBits_t WAVE_TYPE, RegBits_t MSBOUT, RegBits_t TRIGGER, RegBits_t SYNCSEL, RegBits_t SYNCOUT)
+{
+	u16 temp = 0x08D3;				//reserved B0, B1, B4, B6, B7 and 24 bit mode B11 are '1'
+
+	temp |= SYNCOUT << 2;
+	temp |= SYNCSEL << 3;
+	temp |= TRIGGER << 5;
+	temp |= MSBOUT << 8;
+	temp |= WAVE_TYPE << 9;
+	temp |= DAC_EN << 10;
+
+	return AD5932_CREG | temp;
+}
+
+// ....................................................................................................................
+// @brief:      Hash of a plan request
+// @param[in]:  Request parameters
+// @return:     Cache index
+// ....................................................................................................................
+static u32 AD5932_PlanHash(u32 startF, u32 stopF, u64 duration, u32 mclk)
+{
+	u32 h = 2166136261u;
+
+	h = (h ^ startF) * 16777619u;
+	h = (h ^ stopF) * 16777619u;
+	h = (h ^ (u32)duration) * 16777619u;
+	h = (h ^ (u32)(duration >> 32)) * 16777619u;
+	h = (h ^ mclk) * 16777619u;
+	return (h ^ (h >> 16)) & (AD5932_PLAN_CACHE_SIZE - 1);
+}
+
+// ....................................................................................................................
+// @brief:      Cached AD5932_PlanSweep(). No allocation, the plan lives in the cache.
+// @param[in]:  Start frequency in Hz
+// @param[in]:  Stop frequency in Hz
+// @param[in]:  Sweep duration in ns
+// @param[in]:  MCLK frequency in Hz
+// @return:     The plan (valid until the next miss), NULL if no plan is possible.
+// ....................................................................................................................
+const AD5932Plan_t* AD5932_PlanCached(u32 startF, u32 stopF, u64 duration, u32 mclk)
+{
+	AD5932PlanEntry_t* entry;
+	AD5932Plan_t plan;
+	u32 index, i;
+
+	index = AD5932_PlanHash(startF, stopF, duration, mclk);
+	for (i = 0; i < AD5932_PLAN_CACHE_PROBE; i++)
+	{
+		entry = &ad5932PlanCache[(index + i) & (AD5932_PLAN_CACHE_SIZE - 1)];
+		if (entry->valid && (entry->startF == startF) && (entry->stopF == stopF) && (entry->duration == duration) && (entry->mclk == mclk))
+		{
+			ad5932PlanCacheHits++;
+			return &entry->plan;
+		}
+	}
+
+	ad5932PlanCacheMisses++;
+
+	//a failed request leaves the cache as it was
+	if (AD5932_PlanSweep(startF, stopF, duration, mclk, &plan) != 0)
+		return NULL;
+
+	//first free probed entry, round-robin replacement otherwise
+	for (i = 0; i < AD5932_PLAN_CACHE_PROBE; i++)
+	{
+		if (!ad5932PlanCache[(index + i) & (AD5932_PLAN_CACHE_SIZE - 1)].valid)
+			break;
+	}
+	if (i == AD5932_PLAN_CACHE_PROBE)
+	{
+		i = ad5932PlanCacheVictim;
+		ad5932PlanCacheVictim = (ad5932PlanCacheVictim + 1) % AD5932_PLAN_CACHE_PROBE;
+	}
+
+	entry = &ad5932PlanCache[(index + i) & (AD5932_PLAN_CACHE_SIZE - 1)];
+	entry->plan = plan;
+	entry->startF = startF;
+	entry->stopF = stopF;
+	entry->duration = duration;
+	entry->mclk = mclk;
+	entry->valid = true;
+	return &entry->plan;
+}
+
+// ....................................................................................................................
+// @brief:      Empties the plan cache and its statistics, ie. after an MCLK calibration.
+// @param[in]:  none
+// @return:     none
+// ....................................................................................................................
+void AD5932_PlanCacheClear(void)
+{
+	u32 i;
+
+	for (i = 0; i < AD5932_PLAN_CACHE_SIZE; i++)
+		ad5932PlanCache[i].valid = false;
+	ad5932PlanCacheVictim = 0;
+	ad5932PlanCacheHits = 0;
+	ad5932PlanCacheMisses = 0;
+}
+
+// ....................................................................................................................
+// @brief:      Hit / miss statistics of the plan cache
+// @param[out]: Number of hits, can be NULL
+// @param[out]: Number of misses, can be NULL
+// @return:     none
+// ....................................................................................................................
+void AD5932_PlanCacheStats(u32* hits, u32* misses)
+{
+	if (hits != NULL)
+		*hits = ad5932PlanCacheHits;
+	if (misses != NULL)
+		*misses = ad5932PlanCacheMisses;
+}
+
+// ....................................................................................................................
+// @brief:      Converts a frequency to a tuning word, rounded
+// @param[in]:  Frequency in Hz, MCLK in Hz
+// @return:     Tuning word
+// ....................................................................................................................
+static u32 AD5932_FitWord(u32 frequency, u32 mclk)
+{
+	return ((u64)frequency * AD5932_ACCU_RESOLUTION + mclk / 2) / mclk;
+}
+
+// ....................................................................................................................
+// @brief:      Tries one segment length: picks NINCR / TINT, puts the staircase on the profile and measures the error
+// @param[in]:  Profile, context, MCLK
+// @param[in]:  Segment start in MCLK periods
+// @param[in]:  Segment length in MCLK periods
+// @param[in]:  Frequency budget in Hz
+// @param[in]:  Longest step (TINT) in MCLK periods
+// @param[out]: The segment, start / duration / errors filled
+// @return:     true if the segment is within the budgets
+// ....................................................................................................................
+static bool AD5932_FitTry(AD5932_Profile_t profile, void* context, u32 mclk, u64 start, u64 length, u32 freqError, u32 maxTint, AD5932FitSegment_t* segment)
+{
+	u32 nincr, minNincr, maxNincr, n, k, tint, startWord, stopWord, span, deltaWord, endWord, j;
+	u64 cycles, t, cost, bestCost, maxError = 0;
+	s64 line, error, ripple, curve = 0;
+	s64 sample[3];
+	bool decremental;
+
+	if (length < 6)
+		return false;
+	//NINCR range: TINT 2..the longest step
+	maxNincr = (length / 2 - 1 > 4095) ? 4095 : (u32)(length / 2 - 1);
+	minNincr = (u32)((length + maxTint - 1) / maxTint - 1);
+	if (minNincr < 2)
+		minNincr = 2;
+	if (minNincr > maxNincr)
+		return false;
+
+	//staircase on the line through the profile at the first and last step centre, the centres taken at the finest steps
+	tint = (u32)(length / (maxNincr + 1));
+	startWord = AD5932_FitWord(profile(context, AD5932_PlanTime(start + tint / 2, mclk)), mclk);
+	stopWord = AD5932_FitWord(profile(context, AD5932_PlanTime(start + length - tint / 2, mclk)), mclk);
+	if ((startWord == 0) || (startWord >= AD5932_NYQUIST_WORD) || (stopWord >= AD5932_NYQUIST_WORD))
+		return false;
+	decremental = stopWord < startWord;
+	span = decremental ? startWord - stopWord : stopWord - startWord;
+
+	//NINCR with the least half step + DFREQ rounding error: a small integer DFREQ that divides the span well
+	nincr = maxNincr;
+	bestCost = (u64)-1;
+	k = (span + maxNincr - 1) / maxNincr;
+	for (j = (k > 1) ? k : 1; (span != 0) && (j < k + 4); j++)
+	{
+		n = (span + j / 2) / j;
+		n = (n < minNincr) ? minNincr : ((n > maxNincr) ? maxNincr : n);
+		deltaWord = (span + n / 2) / n;
+		cost = deltaWord + 2 * (((u64)deltaWord * n > span) ? (u64)deltaWord * n - span : span - (u64)deltaWord * n);
+		if (cost < bestCost)
+		{
+			bestCost = cost;
+			nincr = n;
+		}
+	}
+	tint = (u32)(length / (nincr + 1));
+	cycles = (u64)tint * (nincr + 1);
+	deltaWord = (span + nincr / 2) / nincr;
+	endWord = decremental ? startWord - deltaWord * nincr : startWord + deltaWord * nincr;
+	if ((deltaWord >= AD5932_NYQUIST_WORD) || (endWord == 0) || (endWord >= AD5932_NYQUIST_WORD) || (decremental && ((u64)deltaWord * nincr >= startWord)))
+		return false;
+
+	//line distance from the profile + half step, line in tuning word * TINT units. The half step is rounded up and
+	//1 Hz is added for the truncated line and the whole Hz of the profile, so the error is never underestimated.
+	ripple = (((s64)deltaWord * mclk + (1 << 25) - 1) >> 25) + 1;
+	for (j = 0; j <= AD5932_FIT_CHECKS; j++)
+	{
+		t = start + ((cycles - 1) * j) / AD5932_FIT_CHECKS;
+		line = (s64)startWord * tint + (decremental ? -1 : 1) * (s64)deltaWord * ((s64)(t - start) - tint / 2);
+		line = (line * mclk) / ((s64)tint << 24);
+		sample[2] = sample[1];
+		sample[1] = sample[0];
+		sample[0] = (s64)profile(context, AD5932_PlanTime(t, mclk));
+		error = line - sample[0];
+		if (error < 0)
+			error = -error;
+		error += ripple;
+		if (error > (s64)freqError)
+			return false;
+		if ((u64)error > maxError)
+			maxError = error;
+		if (j >= 2)
+		{
+			error = sample[0] - 2 * sample[1] + sample[2];
+			if (error < 0)
+				error = -error;
+			if (error > curve)
+				curve = error;
+		}
+	}
+
+	//between two points the profile can bend away from the line by 1/8 of its second difference
+	maxError += (curve + 7) / 8;
+	if (maxError > freqError)
+		return false;
+
+	segment->plan.words[AD5932_PLAN_FSTART_LO] = AD5932_FSTART_LO | (startWord & 0x0FFF);
+	segment->plan.words[AD5932_PLAN_FSTART_HI] = AD5932_FSTART_HI | ((startWord >> 12) & 0x0FFF);
+	segment->plan.words[AD5932_PLAN_DFREQ_LO] = AD5932_DFREQ_LO | (deltaWord & 0x0FFF);
+	segment->plan.words[AD5932_PLAN_DFREQ_HI] = AD5932_DFREQ_HI | ((deltaWord >> 12) & 0x07FF) | (decremental ? 0x0800 : 0);
+	segment->plan.words[AD5932_PLAN_TINT] = AD5932_TINT_MCLKCYCLES | tint;
+	segment->plan.words[AD5932_PLAN_NINCR] = AD5932_NINCR | nincr;
+	segment->plan.endError = (u32)((((endWord > stopWord) ? endWord - stopWord : stopWord - endWord) * (u64)mclk) >> 24);
+	segment->plan.durationError = (u32)AD5932_PlanTime(length - cycles, mclk);
+	segment->start = AD5932_PlanTime(start, mclk);
+	segment->duration = AD5932_PlanTime(cycles, mclk);
+	segment->maxError = (u32)maxError;
+	return true;
+}
+
+// ....................................................................................................................
+// @brief:      Fits a frequency profile with the fewest MCLK based sweeps within the error budgets.
+//				Send a segment with AD5932_SendPlan() (control register first) and trigger CTRL at its start.
+// @param[in]:  Profile, frequency in Hz at a time in ns
+// @param[in]:  Context of the profile
+// @param[in]:  Profile duration in ns
+// @param[in]:  Frequency error budget in Hz
+// @param[in]:  Timing error budget in ns: longest step, the gap between two segments, and the allowed shortfall of
+//				the whole duration
+// @param[in]:  Reprogramming time in ns, the gap between two segments and the shortest segment: the bus time of the
+//				control register and the AD5932_PLAN_WORDS plan words, plus the CTRL pulse. 0 if not limited.
+// @param[in]:  MCLK frequency in Hz
+// @param[out]: Segments
+// @param[in]:  Size of the segment array
+// @return:     Number of segments. 0xFFF0 if the budgets can not be met (profile too steep / above MCLK/2, or
+//				the reprogramming does not fit) or more segments would be needed.
+// ....................................................................................................................
+s32 AD5932_PlanFit(AD5932_Profile_t profile, void* context, u64 duration, u32 freqError, u32 timeError, u32 reprogram, u32 mclk, AD5932FitSegment_t* segments, u16 maxSegments)
+{
+	u64 total, start = 0, low, high, middle, cap, tolerance, guess, gap, shortest;
+	AD5932FitSegment_t trial;
+	u32 maxTint;
+	u16 count = 0;
+
+	if ((profile == NULL) || (mclk == 0))
+		return AD5932_PARAM_ERROR;
+
+	total = AD5932_PlanCycles(duration, mclk);
+	tolerance = ((u64)timeError * mclk) / 1000000000;
+	gap = AD5932_PlanCycles(reprogram, mclk);
+	maxTint = (tolerance > 2047) ? 2047 : ((tolerance < 2) ? 2 : (u32)tolerance);
+	guess = (u64)maxTint * 4096;
+
+	//after a segment the rest is checked at its end, a rest after the gap is still off the profile
+	while ((total - start > tolerance) || (count != 0))
+	{
+		if (count >= maxSegments)
+			return AD5932_PARAM_ERROR;
+
+		cap = total - start;
+		if ((cap < 6) && (count != 0) && (gap != 0))
+			return AD5932_PARAM_ERROR;	//no sweep fits after the gap
+		if (cap < 6)
+			break;				//shorter than any sweep, the last step is held
+		if (cap > (u64)maxTint * 4096)
+			cap = (u64)maxTint * 4096;
+		shortest = (gap < cap) ? gap : cap;		//only the last segment can be shorter than the gap
+		if (shortest < 6)
+			shortest = 6;
+
+		//bracket the longest fitting length around the previous one: [low fits, high fails)
+		low = (guess > cap) ? cap : ((guess < shortest) ? shortest : guess);
+		if (AD5932_FitTry(profile, context, mclk, start, low, freqError, maxTint, &segments[count]))
+		{
+			high = (low * 2 > cap) ? cap : low * 2;
+			while ((high > low) && AD5932_FitTry(profile, context, mclk, start, high, freqError, maxTint, &trial))
+			{
+				low = high;
+				segments[count] = trial;
+				high = (high * 2 > cap) ? cap : high * 2;
+			}
+			if (high == low)
+				high++;			//the rest of the profile fits
+		}
+		else
+		{
+			for (high = low; ; )
+			{
+				low = (low / 2 < shortest) ? shortest : low / 2;
+				if (AD5932_FitTry(profile, context, mclk, start, low, freqError, maxTint, &segments[count]))
+					break;
+				if (low == shortest)
+					return AD5932_PARAM_ERROR;
+				high = low;
+			}
+		}
+
+		//down to 1/64 of the length, more precision would not save a segment
+		while ((high - low > 1) && (high - low > low / 64))
+		{
+			middle = low + (high - low) / 2;
+			if (AD5932_FitTry(profile, context, mclk, start, middle, freqError, maxTint, &trial))
+			{
+				low = middle;
+				segments[count] = trial;
+			}
+			else
+				high = middle;
+		}
+		guess = low;
+
+		//the next segment starts where this one really ends, after the reprogramming gap
+		start += (u64)(segments[count].plan.words[AD5932_PLAN_TINT] & 0x07FF) * ((segments[count].plan.words[AD5932_PLAN_NINCR] & 0x0FFF) + 1);
+		count++;
+		if (total - start <= tolerance)
+			break;
+		if (gap > tolerance)
+			return AD5932_PARAM_ERROR;	//the output is off the profile for longer than the timing budget
+		start += gap;
+	}
+	return count;
+}
+
+#endif
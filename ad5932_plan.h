@@ -0,0 +1,65 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_plan.h
+// @brief:      Sweep planner (start / stop / duration to AD5932 register words) with a memoization cache
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+#ifndef __AD5932_PLAN_H
+#define __AD5932_PLAN_H
+
+#include "defs.h"
+#include "ad5932.h"
+
+#ifndef AD5932_PLAN_CACHE_SIZE
+	#define AD5932_PLAN_CACHE_SIZE	16		//cache entries, power of 2
+#endif
+#define AD5932_PLAN_CACHE_PROBE		4		//entries checked from the hash index
+
+#ifndef AD5932_FIT_CHECKS
+	#define AD5932_FIT_CHECKS		64		//profile points checked per fitted segment
+#endif
+
+//register words of a planned sweep, in programming order after the control register
+typedef enum _AD5932_PlanWord_t
+{
+	AD5932_PLAN_FSTART_LO	= 0,
+	AD5932_PLAN_FSTART_HI,
+	AD5932_PLAN_DFREQ_LO,
+	AD5932_PLAN_DFREQ_HI,
+	AD5932_PLAN_TINT,
+	AD5932_PLAN_NINCR,
+	AD5932_PLAN_WORDS
+} AD5932_PlanWord_t;
+
+//planned sweep with its error metrics
+typedef struct
+{
+	u16 words[AD5932_PLAN_WORDS];
+	u32 endError;			//distance of the reached end frequency from the requested stop frequency in Hz
+	u32 durationError;		//distance of the sweep duration from the requested one in ns
+} AD5932Plan_t;
+
+//frequency profile to fit: frequency in Hz at a time in ns from the profile start
+typedef u32 (*AD5932_Profile_t)(void* context, u64 time);
+
+//one fitted segment: a planned sweep and when to trigger it
+typedef struct
+{
+	AD5932Plan_t plan;
+	u64 start;				//start time from the profile start in ns
+	u64 duration;			//ns
+	u32 maxError;			//largest frequency error found against the profile in Hz
+} AD5932FitSegment_t;
+
+s32 AD5932_PlanSweep(u32 startF, u32 stopF, u64 duration, u32 mclk, AD5932Plan_t* plan);
+s32 AD5932_SendPlan(const AD5932Plan_t* plan);
+u16 AD5932_PlanControlWord(RegBits_t WAVE_TYPE, RegBits_t MSBOUT, RegBits_t TRIGGER, RegBits_t SYNCSEL, RegBits_t SYNCOUT);
+const AD5932Plan_t* AD5932_PlanCached(u32 startF, u32 stopF, u64 duration, u32 mclk);
+void AD5932_PlanCacheClear(void);
+void AD5932_PlanCacheStats(u32* hits, u32* misses);
+s32 AD5932_PlanFit(AD5932_Profile_t profile, void* context, u64 duration, u32 freqError, u32 timeError, u32 reprogram, u32 mclk, AD5932FitSegment_t* segments, u16 maxSegments);
+
+#endif
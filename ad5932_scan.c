@@ -0,0 +1,304 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_scan.c
+// @brief:      Step, frequency and time calculations of programmed AD5932 sweeps
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+// --------------------------------------------------------------------------------------------------------------------
+// Includes
+// --------------------------------------------------------------------------------------------------------------------
+
+#include "main.h"
+#include "config.h"
+#if USE_AD5932
+
+#include <math.h>
+#include "ad5932_scan.h"
+
+// --------------------------------------------------------------------------------------------------------------------
+// Defines
+// --------------------------------------------------------------------------------------------------------------------
+
+#define NS_PER_SEC			1000000000.0
+#define TRACK_NEWTON		5					//Newton steps of the inverse digamma
+#define EULER_GAMMA			0.5772156649015329
+#define DIGAMMA_MIN			(1.0 / 16777216.0)	//below a / d = 1 / 2^23 of the smallest valid word over the largest DFREQ
+
+// --------------------------------------------------------------------------------------------------------------------
+// Notes
+// --------------------------------------------------------------------------------------------------------------------
+
+//Step k (0..NINCR) outputs the tuning word W(k) = FSTART +/- k * DFREQ, f(k) = W(k) * MCLK / 2^24.
+//MCLK_INP_BASED: every step lasts TINT MCLK periods, so the step start time is simply k * TINT / MCLK.
+//WAVE_OUT_BASED: every step lasts TINT output periods, TINT * 2^24 / (W(k) * MCLK), so the start time of step k is
+//	T(k) = TINT * 2^24 / MCLK * sum(i = 0..k-1) 1 / W(i)
+//The sum of an arithmetic series' reciprocals is a digamma difference: sum 1 / (a + i * d) = (psi(a / d + k) - psi(a / d)) / d
+//so T(k) is O(1) for any k. The inverse (which step is running at time t) solves the same form for k with the
+//inverse digamma function, a fixed number of Newton steps, then the exact T(k) corrects the estimate by a step at
+//most, so the tracker is O(1) too. Wrapped sweeps (the words leave 1..2^24 - 1, AD5932_ValidateSweep() rejects them)
+//are not arithmetic series any more, they are tracked approximately.
+//Times are in ns. The chip counts whole MSB periods, so the real step boundaries can be up to one MCLK period later.
+
+// --------------------------------------------------------------------------------------------------------------------
+// Functions
+// --------------------------------------------------------------------------------------------------------------------
+
+// ....................................................................................................................
+// @brief:      Digamma function, asymptotic series (terms to x^-10) after shifting the argument to x >= 6.
+//				x is clamped to DIGAMMA_MIN, so the shift loop runs 6 times at most.
+// @param[in]:  x > 0
+// @return:     psi(x)
+// ....................................................................................................................
+static double AD5932_Digamma(double x)
+{
+	double ret = 0.0, x2;
+
+	if (!(x >= DIGAMMA_MIN))
+		x = DIGAMMA_MIN;
+	while (x < 6.0)
+	{
+		ret -= 1.0 / x;
+		x += 1.0;
+	}
+	x2 = 1.0 / (x * x);
+	return ret + log(x) - 0.5 / x - x2 * (1.0 / 12.0 - x2 * (1.0 / 120.0 - x2 * (1.0 / 252.0 - x2 * (1.0 / 240.0 - x2 / 132.0))));
+}
+
+// ....................................................................................................................
+// @brief:      Sum of 1 / W(i) for i = 0..k-1, in closed form.
+// @param[in]:  Sweep
+// @param[in]:  Number of steps
+// @return:     The sum, 1 / tuning word unit
+// ....................................................................................................................
+static double AD5932_ReciprocalSum(const AD5932Sweep_t* sweep, u32 k)
+{
+	double a = (double)sweep->startWord;
+	double d = (double)sweep->deltaWord;
+
+	if (k == 0)
+		return 0.0;
+	if (sweep->deltaWord == 0)
+		return (double)k / a;
+
+	//a decremental series is the incremental one from its last element
+	if (sweep->sweepType == DECREMENTAL_SWEEP)
+		a -= (double)(k - 1) * d;
+
+	return (AD5932_Digamma(a / d + (double)k) - AD5932_Digamma(a / d)) / d;
+}
+
+// ....................................................................................................................
+// @brief:      Trigamma function (derivative of digamma), asymptotic series after shifting the argument to x >= 6.
+// @param[in]:  x > 0, clamped to DIGAMMA_MIN
+// @return:     psi'(x)
+// ....................................................................................................................
+static double AD5932_Trigamma(double x)
+{
+	double ret = 0.0, x2;
+
+	if (!(x >= DIGAMMA_MIN))
+		x = DIGAMMA_MIN;
+	while (x < 6.0)
+	{
+		ret += 1.0 / (x * x);
+		x += 1.0;
+	}
+	x2 = 1.0 / (x * x);
+	return ret + 1.0 / x + 0.5 * x2 + x2 / x * (1.0 / 6.0 - x2 * (1.0 / 30.0 - x2 / 42.0));
+}
+
+// ....................................................................................................................
+// @brief:      Inverse of the digamma function: Newton steps from the usual starting guess, a fixed number of them.
+// @param[in]:  t
+// @return:     y > 0 with psi(y) = t
+// ....................................................................................................................
+static double AD5932_InverseDigamma(double t)
+{
+	double y;
+	u32 i;
+
+	y = (t >= -2.22) ? exp(t) + 0.5 : -1.0 / (t + EULER_GAMMA);
+	for (i = 0; i < TRACK_NEWTON; i++)
+		y -= (AD5932_Digamma(y) - t) / AD5932_Trigamma(y);
+	return y;
+}
+
+// ....................................................................................................................
+// @brief:      Tuning word of a sweep step
+// @param[in]:  Sweep
+// @param[in]:  Step index, clamped to NINCR
+// @return:     24 bit tuning word
+// ....................................................................................................................
+u32 AD5932_StepWord(const AD5932Sweep_t* sweep, u32 step)
+{
+	if (step > sweep->increment)
+		step = sweep->increment;
+
+	if (sweep->sweepType == DECREMENTAL_SWEEP)
+		return (sweep->startWord - step * sweep->deltaWord) & 0x00FFFFFF;
+	return (sweep->startWord + step * sweep->deltaWord) & 0x00FFFFFF;
+}
+
+// ....................................................................................................................
+// @brief:      Output frequency of a sweep step
+// @param[in]:  Sweep
+// @param[in]:  Step index, clamped to NINCR
+// @return:     Frequency in Hz
+// ....................................................................................................................
+u32 AD5932_StepFrequency(const AD5932Sweep_t* sweep, u32 step)
+{
+	return (u64)AD5932_StepWord(sweep, step) * sweep->mclk / AD5932_ACCU_RESOLUTION;
+}
+
+// ....................................................................................................................
+// @brief:      Start time of a sweep step, relative to the CTRL trigger. O(1) for both increment bases.
+// @param[in]:  Sweep
+// @param[in]:  Step index, NINCR + 1 gives the end of the sweep
+// @return:     Time in ns
+// ....................................................................................................................
+u64 AD5932_StepStartTime(const AD5932Sweep_t* sweep, u32 step)
+{
+	double t;
+
+	if (step > (u32)sweep->increment + 1)
+		step = sweep->increment + 1;
+
+	if (sweep->incrementBase == WAVE_OUT_BASED)
+		t = (double)sweep->intervall * AD5932_ACCU_RESOLUTION * AD5932_ReciprocalSum(sweep, step);
+	else
+		t = (double)sweep->intervall * step;
+
+	return (u64)(t * NS_PER_SEC / sweep->mclk + 0.5);
+}
+
+// ....................................................................................................................
+// @brief:      Running step of a sweep, without reading the chip. O(1) for both increment bases.
+// @param[in]:  Sweep
+// @param[in]:  Time since the CTRL trigger in ns
+// @return:     Step index, NINCR after the end of the sweep
+// ....................................................................................................................
+u32 AD5932_TrackStep(const AD5932Sweep_t* sweep, u64 elapsed)
+{
+	double h, a, d, k;
+	u32 step;
+
+	if ((sweep->mclk == 0) || (sweep->intervall == 0))
+		return 0;
+
+	h = (double)elapsed * sweep->mclk / NS_PER_SEC / sweep->intervall;		//elapsed time in TINT units
+
+	if (sweep->incrementBase != WAVE_OUT_BASED)
+		k = h;
+	else
+	{
+		a = (double)sweep->startWord;
+		d = (double)sweep->deltaWord;
+		h /= AD5932_ACCU_RESOLUTION;
+		if ((sweep->deltaWord == 0) || (h * d < 1e-9))
+			k = h * a;
+		else if (sweep->sweepType == DECREMENTAL_SWEEP)
+			k = a / d + 1.0 - AD5932_InverseDigamma(AD5932_Digamma(a / d + 1.0) - h * d);
+		else
+			k = AD5932_InverseDigamma(AD5932_Digamma(a / d) + h * d) - a / d;
+	}
+
+	if (!(k < (double)sweep->increment))
+		return sweep->increment;
+	step = (k > 0.0) ? (u32)k : 0;
+
+	//correct the integral approximation with the exact step times, by one step at most
+	if (sweep->incrementBase == WAVE_OUT_BASED)
+	{
+		if ((step > 0) && (AD5932_StepStartTime(sweep, step) > elapsed))
+			step--;
+		else if ((step < sweep->increment) && (AD5932_StepStartTime(sweep, step + 1) <= elapsed))
+			step++;
+	}
+
+	return step;
+}
+
+// ....................................................................................................................
+// @brief:      Output frequency of a running sweep, without reading the chip.
+// @param[in]:  Sweep
+// @param[in]:  Time since the CTRL trigger in ns
+// @return:     Frequency in Hz
+// ....................................................................................................................
+u32 AD5932_TrackFrequency(const AD5932Sweep_t* sweep, u64 elapsed)
+{
+	return AD5932_StepFrequency(sweep, AD5932_TrackStep(sweep, elapsed));
+}
+
+// ....................................................................................................................
+// @brief:      Running step of the sweep programmed into the AD5932, since the last CTRL trigger.
+// @param[in]:  Current time in us (AD5932_SetTimeBase() time)
+// @return:     Step index
+// ....................................................................................................................
+u32 AD5932_CurrentStep(u32 now)
+{
+	return AD5932_TrackStep(AD5932_GetSweep(), (u64)(now - AD5932_GetTriggerTime()) * 1000);
+}
+
+// ....................................................................................................................
+// @brief:      Output frequency of the sweep programmed into the AD5932, since the last CTRL trigger.
+// @param[in]:  Current time in us (AD5932_SetTimeBase() time)
+// @return:     Frequency in Hz
+// ....................................................................................................................
+u32 AD5932_CurrentFrequency(u32 now)
+{
+	return AD5932_StepFrequency(AD5932_GetSweep(), AD5932_CurrentStep(now));
+}
+
+// ....................................................................................................................
+// @brief:      Total duration of a sweep, from the CTRL trigger to the end of the last (NINCR) step. O(1).
+// @param[in]:  Sweep
+// @return:     Duration in ns
+// ....................................................................................................................
+u64 AD5932_SweepDuration(const AD5932Sweep_t* sweep)
+{
+	return AD5932_StepStartTime(sweep, sweep->increment + 1);
+}
+
+// ....................................................................................................................
+// @brief:      Writes the start time of steps first..first+count-1 into the caller's buffer, no allocation.
+//				WAVE_OUT_BASED times are accumulated with an exact running sum instead of the digamma form,
+//				so a full 4096 step timeline costs one division per step (tools/ad5932_timelinebench measures it).
+// @param[in]:  Sweep
+// @param[in]:  First step index
+// @param[in]:  Number of steps, the list is cut at NINCR + 1 (end of the sweep)
+// @param[out]: Start times in ns, relative to the CTRL trigger
+// @return:     Number of written entries
+// ....................................................................................................................
+u32 AD5932_SweepTimeline(const AD5932Sweep_t* sweep, u32 first, u32 count, u64* times)
+{
+	double scale, sum;
+	u32 i, last;
+
+	last = sweep->increment + 1;
+	if (first > last)
+		return 0;
+	if (count > last - first + 1)
+		count = last - first + 1;
+
+	if (sweep->incrementBase != WAVE_OUT_BASED)
+	{
+		//integer only: step * TINT * 1e9 / MCLK, MCLK base times fit easily
+		for (i = 0; i < count; i++)
+			times[i] = ((u64)(first + i) * sweep->intervall * 1000000000 + sweep->mclk / 2) / sweep->mclk;
+		return count;
+	}
+
+	scale = (double)sweep->intervall * AD5932_ACCU_RESOLUTION * NS_PER_SEC / sweep->mclk;
+	sum = AD5932_ReciprocalSum(sweep, first);
+	for (i = 0; i < count; i++)
+	{
+		times[i] = (u64)(sum * scale + 0.5);
+		sum += 1.0 / (double)AD5932_StepWord(sweep, first + i);
+	}
+	return count;
+}
+
+#endif
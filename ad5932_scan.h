@@ -0,0 +1,26 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_scan.h
+// @brief:      Step, frequency and time calculations of programmed AD5932 sweeps
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+#ifndef __AD5932_SCAN_H
+#define __AD5932_SCAN_H
+
+#include "defs.h"
+#include "ad5932.h"
+
+u32 AD5932_StepWord(const AD5932Sweep_t* sweep, u32 step);
+u32 AD5932_StepFrequency(const AD5932Sweep_t* sweep, u32 step);
+u64 AD5932_StepStartTime(const AD5932Sweep_t* sweep, u32 step);
+u32 AD5932_TrackStep(const AD5932Sweep_t* sweep, u64 elapsed);
+u32 AD5932_TrackFrequency(const AD5932Sweep_t* sweep, u64 elapsed);
+u32 AD5932_CurrentStep(u32 now);
+u32 AD5932_CurrentFrequency(u32 now);
+u64 AD5932_SweepDuration(const AD5932Sweep_t* sweep);
+u32 AD5932_SweepTimeline(const AD5932Sweep_t* sweep, u32 first, u32 count, u64* times);
+
+#endif
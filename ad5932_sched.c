@@ -0,0 +1,278 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_sched.c
+// @brief:      Earliest deadline first scheduler of multi-channel AD5932 sweep jobs
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+// --------------------------------------------------------------------------------------------------------------------
+// Includes
+// --------------------------------------------------------------------------------------------------------------------
+
+#include "main.h"
+#include "config.h"
+#if USE_AD5932
+
+#include <string.h>
+#include "ad5932_sched.h"
+
+// --------------------------------------------------------------------------------------------------------------------
+// Notes
+// --------------------------------------------------------------------------------------------------------------------
+
+//A job is a sweep for one channel (AD5932Dev_t) with a deadline: the time base value when its CTRL has to be
+//triggered. The queue is kept sorted by deadline, so both the programming and the triggers go in deadline order (EDF).
+//AD5932_SchedTask() is called from the main loop (or a timer, see AD5932_SchedNextDeadline()). It triggers every
+//programmed job which is due, then programs the queued jobs, earliest deadline first. A chip holds one sweep, so a job
+//is programmed only when the earlier job of the same channel has been triggered. A job submitted later with an earlier
+//deadline than the programmed job of its channel overwrites the chip, the other job is programmed again after it.
+//Programming a sweep takes AD5932_SCHED_SWEEP_WORDS words on the bus, AD5932_SchedBusTime() gives its time from the
+//SCLK. AD5932_SchedSubmit() uses it for the EDF feasibility check: the queued programming, in deadline order, has to
+//fit before every deadline. A job behind an earlier job of its channel can not go on the bus before that deadline,
+//and a programmed job that an earlier job of its channel takes over is programmed again, so both are counted that
+//way. The programming of a job blocks the task, so it is not started when it would end after the deadline (plus the
+//tolerance) of a programmed earlier job: that trigger goes first, the check counts this wait too. If the queue does
+//not fit, the job is queued anyway, but the caller is told that it will be late.
+//A trigger later than the tolerance, or a failed programming, is a miss: it is counted and reported to the miss
+//callback. The trigger accuracy is the call period of AD5932_SchedTask().
+//The scheduler acquires the channel (with its own address as owner) from programming until the trigger.
+//Every channel needs its own CTRL trigger, given to AD5932_SchedInit(): the common CTRL pin would start all chips at
+//the deadline of one of them.
+//tools/ad5932_schedreplay replays recorded job traces through the unmodified scheduler on the host, on a virtual clock.
+
+// --------------------------------------------------------------------------------------------------------------------
+// Functions
+// --------------------------------------------------------------------------------------------------------------------
+
+// ....................................................................................................................
+// @brief:      Sets up an empty scheduler
+// @param[in]:  Time base (us)
+// @param[in]:  SCLK of the bus in Hz, see AD5932_ConfigSPI()
+// @param[in]:  Allowed lateness of the triggers in us
+// @param[in]:  CTRL trigger of a channel. It must start that chip only and return at once: the common CTRL pin
+//				(AD5932_TriggerCTRLPin()) would start every chip and wait 100 us in AD5932_SchedTask().
+// @param[in]:  Deadline miss report, can be NULL
+// @return:     0 if OK, 0xFFF0 if the time base or the trigger is NULL (the scheduler takes no jobs then).
+// ....................................................................................................................
+s32 AD5932_SchedInit(AD5932Sched_t* sched, AD5932_TimeBase_t timeBase, u32 sclk, u32 tolerance, AD5932_SchedTrigger_t trigger, AD5932_SchedMiss_t miss)
+{
+	memset(sched, 0, sizeof(*sched));
+	if ((timeBase == NULL) || (trigger == NULL))
+		return AD5932_PARAM_ERROR;
+
+	sched->timeBase = timeBase;
+	sched->sclk = sclk;
+	sched->tolerance = tolerance;
+	sched->trigger = trigger;
+	sched->miss = miss;
+	return 0;
+}
+
+// ....................................................................................................................
+// @brief:      Bus time of command words
+// @param[in]:  Number of 16 bit command words
+// @return:     Time in us, rounded up
+// ....................................................................................................................
+u32 AD5932_SchedBusTime(const AD5932Sched_t* sched, u16 words)
+{
+	u32 sclk = (sched->sclk != 0) ? sched->sclk : 1000000;
+
+	return (u32)(((u64)words * 16 * 1000000 + sclk - 1) / sclk) + words * AD5932_SCHED_WORD_OVERHEAD;
+}
+
+// ....................................................................................................................
+// @brief:      Removes a queued job
+// @param[in]:  Index in the queue
+// @return:     none
+// ....................................................................................................................
+static void AD5932_SchedRemove(AD5932Sched_t* sched, u08 index)
+{
+	sched->count--;
+	memmove(&sched->entry[index], &sched->entry[index + 1], (sched->count - index) * sizeof(AD5932SchedEntry_t));
+}
+
+// ....................................................................................................................
+// @brief:      Counts and reports a miss
+// @param[in]:  Job, lateness in us, result of the programming
+// @return:     none
+// ....................................................................................................................
+static void AD5932_SchedMissed(AD5932Sched_t* sched, const AD5932Job_t* job, u32 lateness, s32 result)
+{
+	sched->missed++;
+	if (sched->miss != NULL)
+		sched->miss(job, lateness, result);
+}
+
+// ....................................................................................................................
+// @brief:      Queues a job in deadline order
+// @param[in]:  Job, copied
+// @return:     0 if the queued jobs can be programmed in time, 1 if the job (or a later one) is predicted to miss its
+//              deadline - it is queued anyway. 0xFFF0 if the queue is full, the job has no channel or
+//				AD5932_SchedInit() failed.
+// ....................................................................................................................
+s32 AD5932_SchedSubmit(AD5932Sched_t* sched, const AD5932Job_t* job)
+{
+	u32 busy, start;
+	u08 i, j, k, pos;
+
+	if ((sched->trigger == NULL) || (job->dev == NULL) || (sched->count >= AD5932_SCHED_JOBS))
+		return AD5932_PARAM_ERROR;
+
+	//after the jobs with the same or earlier deadline (wrap-around safe)
+	for (pos = sched->count; pos > 0; pos--)
+		if ((s32)(sched->entry[pos - 1].job.deadline - job->deadline) <= 0)
+			break;
+
+	memmove(&sched->entry[pos + 1], &sched->entry[pos], (sched->count - pos) * sizeof(AD5932SchedEntry_t));
+	sched->entry[pos].job = *job;
+	sched->entry[pos].busTime = AD5932_SchedBusTime(sched, AD5932_SCHED_SWEEP_WORDS);
+	sched->entry[pos].programmed = false;
+	sched->count++;
+
+	//EDF feasibility on one bus: the programming of all jobs up to a deadline has to fit before it. busy is the time
+	//base value when the bus is free.
+	busy = sched->timeBase();
+	for (i = 0; i < sched->count; i++)
+	{
+		//the nearest earlier job of the channel, the chip is free after its trigger
+		for (j = i; j > 0; j--)
+			if (sched->entry[j - 1].job.dev == sched->entry[i].job.dev)
+				break;
+		if (sched->entry[i].programmed && (j == 0))
+			continue;		//stays on its chip
+
+		start = busy;
+		if ((j > 0) && ((s32)(sched->entry[j - 1].job.deadline - start) > 0))
+			start = sched->entry[j - 1].job.deadline;
+
+		//AD5932_SchedTask() waits for the triggers the programming would make late
+		for (k = 0; k < i; k++)
+			if (((s32)(start - sched->entry[k].job.deadline) < 0) &&
+				((s32)(start + sched->entry[i].busTime - sched->entry[k].job.deadline) > (s32)sched->tolerance))
+				start = sched->entry[k].job.deadline;
+		busy = start + sched->entry[i].busTime;
+		if ((s32)(busy - sched->entry[i].job.deadline) > (s32)sched->tolerance)
+			return 1;
+	}
+	return 0;
+}
+
+// ....................................................................................................................
+// @brief:      Removes a job. A programmed job is not triggered, its channel is released.
+// @param[in]:  User tag of the job
+// @return:     0 if found, 0xFFF0 if not.
+// ....................................................................................................................
+s32 AD5932_SchedCancel(AD5932Sched_t* sched, u32 id)
+{
+	u08 i;
+
+	for (i = 0; i < sched->count; i++)
+	{
+		if (sched->entry[i].job.id != id)
+			continue;
+		if (sched->entry[i].programmed)
+			AD5932_DevRelease(sched->entry[i].job.dev, sched);
+		AD5932_SchedRemove(sched, i);
+		return 0;
+	}
+	return AD5932_PARAM_ERROR;
+}
+
+// ....................................................................................................................
+// @brief:      Triggers the due jobs and programs the queued ones, in deadline order. Call it often.
+// @param[in]:  none
+// @return:     none
+// ....................................................................................................................
+void AD5932_SchedTask(AD5932Sched_t* sched)
+{
+	AD5932SchedEntry_t* e;
+	u32 now, lateness;
+	u08 i, j;
+	s32 ret;
+
+	while (1)
+	{
+		//due triggers first, programming takes bus time
+		now = sched->timeBase();
+		for (i = 0; i < sched->count; )
+		{
+			e = &sched->entry[i];
+			if (!e->programmed || ((s32)(now - e->job.deadline) < 0))
+			{
+				i++;
+				continue;
+			}
+			sched->trigger(e->job.dev);
+			AD5932_DevRelease(e->job.dev, sched);
+
+			sched->done++;
+			lateness = now - e->job.deadline;
+			if (lateness > sched->maxLateness)
+				sched->maxLateness = lateness;
+			if (lateness > sched->tolerance)
+				AD5932_SchedMissed(sched, &e->job, lateness, 0);
+			AD5932_SchedRemove(sched, i);
+		}
+
+		//the earliest queued job whose channel is free
+		for (i = 0; i < sched->count; i++)
+		{
+			e = &sched->entry[i];
+			if (e->programmed)
+				continue;
+			for (j = 0; j < i; j++)
+				if (sched->entry[j].job.dev == e->job.dev)
+					break;
+			if (j < i)
+				continue;		//an earlier job of the channel is still waiting
+
+			//the task is blocked while the words go out: a due trigger of an earlier job goes first. Checked before
+			//the channel is acquired: a later job may be programmed on it, the channel must stay owned for that one.
+			for (j = 0; j < i; j++)
+				if (sched->entry[j].programmed &&
+					((s32)(now + e->busTime - sched->entry[j].job.deadline) > (s32)sched->tolerance))
+					return;
+			if (AD5932_DevAcquire(e->job.dev, sched) == 0)
+				break;
+		}
+		if (i >= sched->count)
+			return;
+
+		//a job submitted with an earlier deadline than the programmed one of its channel takes the chip over, the
+		//later job is programmed again after this one is triggered
+		for (j = i + 1; j < sched->count; j++)
+			if (sched->entry[j].programmed && (sched->entry[j].job.dev == e->job.dev))
+				sched->entry[j].programmed = false;
+
+		ret = AD5932_DevSweep(e->job.dev, sched, &e->job.params, e->job.waveType, e->job.msbOut, EXTERNAL_TRIGGER, e->job.syncSel, e->job.syncOut);
+		if (ret == 0)
+		{
+			e->programmed = true;
+			continue;
+		}
+
+		AD5932_DevRelease(e->job.dev, sched);
+		if (ret == AD5932_PORT_BUSY)
+			return;				//bus taken, next call
+		lateness = now - e->job.deadline;
+		AD5932_SchedMissed(sched, &e->job, ((s32)lateness > 0) ? lateness : 0, ret);
+		AD5932_SchedRemove(sched, i);
+	}
+}
+
+// ....................................................................................................................
+// @brief:      Earliest deadline in the queue, to set a timer for the next AD5932_SchedTask() call
+// @param[out]: Deadline in us
+// @return:     true if there is a job
+// ....................................................................................................................
+bool AD5932_SchedNextDeadline(const AD5932Sched_t* sched, u32* deadline)
+{
+	if (sched->count == 0)
+		return false;
+	*deadline = sched->entry[0].job.deadline;
+	return true;
+}
+
+#endif
@@ -0,0 +1,73 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_sched.h
+// @brief:      Earliest deadline first scheduler of multi-channel AD5932 sweep jobs
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+#ifndef __AD5932_SCHED_H
+#define __AD5932_SCHED_H
+
+#include "defs.h"
+#include "ad5932.h"
+#include "ad5932_dev.h"
+
+#ifndef AD5932_SCHED_JOBS
+	#define AD5932_SCHED_JOBS		16		//max. number of queued jobs
+#endif
+
+#define AD5932_SCHED_SWEEP_WORDS	7		//command words of one sweep program
+#define AD5932_SCHED_WORD_OVERHEAD	2		//us, FSYNC and driver time of one command word
+
+//one sweep job: what to program into which chip, and when to start it
+typedef struct
+{
+	AD5932Dev_t* dev;			//channel, must be free (not acquired) when the job is programmed
+	AD5932Params_t params;		//sweep parameters
+	u08 waveType;				//SINE_OUT / TRIANGLE_OUT
+	u08 msbOut;					//MSBOUT_EN / MSBOUT_DISABLE
+	u08 syncSel;				//SYNCSEL_END / SYNCSEL_SUBSEQVENT
+	u08 syncOut;				//SYNCOUT_EN / SYNCOUT_DISABLE
+	u32 deadline;				//time base (us), when CTRL has to be triggered
+	u32 id;						//user tag
+} AD5932Job_t;
+
+//CTRL trigger of a channel, starts that chip only
+typedef void (*AD5932_SchedTrigger_t)(AD5932Dev_t* dev);
+
+//deadline miss report: lateness in us, result of the programming (0 if it was programmed, but triggered late)
+typedef void (*AD5932_SchedMiss_t)(const AD5932Job_t* job, u32 lateness, s32 result);
+
+//queued job
+typedef struct
+{
+	AD5932Job_t job;
+	u32 busTime;				//us, bus time of the command words
+	bool programmed;			//sent to the chip, waits for the trigger
+} AD5932SchedEntry_t;
+
+//scheduler, jobs sorted by deadline
+typedef struct
+{
+	AD5932_TimeBase_t timeBase;
+	AD5932_SchedTrigger_t trigger;
+	AD5932_SchedMiss_t miss;
+	u32 sclk;					//SCLK of the bus in Hz
+	u32 tolerance;				//us, allowed lateness of a trigger
+	u08 count;
+	AD5932SchedEntry_t entry[AD5932_SCHED_JOBS];
+	u32 done;					//triggered jobs
+	u32 missed;					//jobs triggered late or failed
+	u32 maxLateness;			//us
+} AD5932Sched_t;
+
+s32 AD5932_SchedInit(AD5932Sched_t* sched, AD5932_TimeBase_t timeBase, u32 sclk, u32 tolerance, AD5932_SchedTrigger_t trigger, AD5932_SchedMiss_t miss);
+u32 AD5932_SchedBusTime(const AD5932Sched_t* sched, u16 words);
+s32 AD5932_SchedSubmit(AD5932Sched_t* sched, const AD5932Job_t* job);
+s32 AD5932_SchedCancel(AD5932Sched_t* sched, u32 id);
+void AD5932_SchedTask(AD5932Sched_t* sched);
+bool AD5932_SchedNextDeadline(const AD5932Sched_t* sched, u32* deadline);
+
+#endif
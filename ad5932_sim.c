@@ -0,0 +1,288 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_sim.c
+// @brief:      AD5932 output model: phase accumulator jump-ahead and DAC sample rendering of programmed sweeps
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+// --------------------------------------------------------------------------------------------------------------------
+// Includes
+// --------------------------------------------------------------------------------------------------------------------
+
+#include "main.h"
+#include "config.h"
+#if USE_AD5932 && !defined(MCU_FAMILY)
+
+#include <math.h>
+#include "ad5932_sim.h"
+
+// --------------------------------------------------------------------------------------------------------------------
+// Defines
+// --------------------------------------------------------------------------------------------------------------------
+
+#define SIM_MASK			0x00FFFFFFULL	//24 bit accumulator
+#define SIM_ROM_SIZE		(1 << AD5932_SIM_PHASE_BITS)
+#define SIM_DAC_MAX			((1 << AD5932_SIM_DAC_BITS) - 1)
+#define SIM_PI				3.14159265358979323846
+
+// --------------------------------------------------------------------------------------------------------------------
+// Variables
+// --------------------------------------------------------------------------------------------------------------------
+
+static u16 simSineRom[SIM_ROM_SIZE];
+static bool simReady = false;
+
+// --------------------------------------------------------------------------------------------------------------------
+// Notes
+// --------------------------------------------------------------------------------------------------------------------
+
+//Host only (tools, simulations): the file is empty in firmware builds (MCU_FAMILY defined), so the sine table and
+//libm stay out of the target.
+//The model starts the accumulator from 0 at the CTRL trigger (INTERRUPT clears it) and adds the tuning word of the
+//running step every MCLK cycle, as tools/ad5932_vcdsim does. Sample n of the output is the DAC code at cycle n.
+//MCLK_INP_BASED: step k starts at cycle k * TINT and the words form an arithmetic series, so the accumulator at the
+//start of step k has a closed form:
+//	P(k) = TINT * (k * FSTART +/- DFREQ * k * (k - 1) / 2) mod 2^24
+//Any sample of the sweep is then P(k) + (cycle - k * TINT) * W(k), O(1) without replaying the samples before it.
+//WAVE_OUT_BASED: a step ends at the TINT-th accumulator overflow, after ceil((TINT * 2^24 - P) / W) cycles, so the
+//step boundaries depend on the phase the step started with. There is no closed form, but the walk is O(1) per step
+//(at most NINCR steps) instead of O(1) per sample.
+//Because every sample is computed from the exact integer phase, a range rendered from any start point is identical
+//to the same range of a serial render: a sweep can be cut into chunks and the chunks rendered independently (by more
+//threads on the host, see tools/ad5932_render.c). Call AD5932_SimInit() once before rendering from more threads.
+//The DAC is fed with the top AD5932_SIM_PHASE_BITS bits of the accumulator (phase truncation) through the sine ROM
+//or the triangle, and quantized to AD5932_SIM_DAC_BITS.
+
+// --------------------------------------------------------------------------------------------------------------------
+// Functions
+// --------------------------------------------------------------------------------------------------------------------
+
+// ....................................................................................................................
+// @brief:      Builds the sine ROM of the model. Call once before the first render.
+// ....................................................................................................................
+void AD5932_SimInit(void)
+{
+	u32 i;
+
+	if (simReady)
+		return;
+
+	for (i = 0; i < SIM_ROM_SIZE; i++)
+		simSineRom[i] = (u16)floor(SIM_DAC_MAX / 2.0 * (1.0 + sin(2.0 * SIM_PI * i / SIM_ROM_SIZE)) + 0.5);
+	simReady = true;
+}
+
+// ....................................................................................................................
+// @brief:      DAC code of an accumulator phase, after phase truncation
+// @param[in]:  Accumulator, 24 bit
+// @param[in]:  SINE_OUT / TRIANGLE_OUT
+// @return:     DAC code, 0..2^AD5932_SIM_DAC_BITS - 1
+// ....................................................................................................................
+u16 AD5932_SimDac(u32 phase, RegBits_t WAVE_TYPE)
+{
+	u32 index = (phase & SIM_MASK) >> (24 - AD5932_SIM_PHASE_BITS);
+
+	if (WAVE_TYPE == SINE_OUT)
+		return simSineRom[index];
+
+	//triangle: up in the first half cycle, down in the second
+	if (index >= SIM_ROM_SIZE / 2)
+		index = SIM_ROM_SIZE - 1 - index;
+	return (u16)(index >> (AD5932_SIM_PHASE_BITS - 1 - AD5932_SIM_DAC_BITS));
+}
+
+// ....................................................................................................................
+// @brief:      Tuning word of a step (AD5932_StepWord() without linking ad5932_scan.c into host tools)
+// @param[in]:  Sweep
+// @param[in]:  Step index, clamped to NINCR
+// @return:     Tuning word, 24 bit
+// ....................................................................................................................
+static u32 AD5932_SimWord(const AD5932Sweep_t* sweep, u32 step)
+{
+	if (step > sweep->increment)
+		step = sweep->increment;
+
+	if (sweep->sweepType == DECREMENTAL_SWEEP)
+		return (u32)((sweep->startWord - (u64)step * sweep->deltaWord) & SIM_MASK);
+	return (u32)((sweep->startWord + (u64)step * sweep->deltaWord) & SIM_MASK);
+}
+
+// ....................................................................................................................
+// @brief:      Length of a step in MCLK cycles
+// @param[in]:  Sweep
+// @param[in]:  Tuning word of the step
+// @param[in]:  Accumulator at the start of the step
+// @return:     Cycles, AD5932_SIM_END if the step never ends
+// ....................................................................................................................
+static u64 AD5932_SimStepLength(const AD5932Sweep_t* sweep, u32 word, u32 phase)
+{
+	if (sweep->incrementBase != WAVE_OUT_BASED)
+		return sweep->intervall;
+	if (word == 0)
+		return AD5932_SIM_END;
+	return ((u64)sweep->intervall * AD5932_ACCU_RESOLUTION - phase + word - 1) / word;
+}
+
+// ....................................................................................................................
+// @brief:      Sets the cursor to the start of a step
+// @param[in]:  Sweep
+// @param[in]:  Step, NINCR + 1 marks the end of the sweep
+// @param[in]:  Start cycle and accumulator of the step
+// @param[out]: Cursor
+// ....................................................................................................................
+static void AD5932_SimEnter(const AD5932Sweep_t* sweep, u32 step, u64 cycle, u32 phase, AD5932SimCursor_t* cursor)
+{
+	u64 length;
+
+	cursor->cycle = cycle;
+	cursor->step = step;
+	cursor->phase = phase;
+	cursor->word = AD5932_SimWord(sweep, step);
+	cursor->stepEnd = AD5932_SIM_END;
+	if (step <= sweep->increment)
+	{
+		length = AD5932_SimStepLength(sweep, cursor->word, phase);
+		if (length != AD5932_SIM_END)
+			cursor->stepEnd = cycle + length;
+	}
+}
+
+// ....................................................................................................................
+// @brief:      Moves the cursor forward to a cycle, crossing step boundaries
+// @param[in]:  Sweep
+// @param[in]:  Cycle, not before the cursor
+// @param[in]:  Cursor, moved to the cycle
+// @return:     false if the cycle is after the end of the sweep (the cursor stops at the end)
+// ....................................................................................................................
+bool AD5932_SimAdvance(const AD5932Sweep_t* sweep, u64 cycle, AD5932SimCursor_t* cursor)
+{
+	u32 phase;
+
+	while ((cycle >= cursor->stepEnd) && (cursor->step <= sweep->increment))
+	{
+		phase = (u32)((cursor->phase + ((cursor->stepEnd - cursor->cycle) & SIM_MASK) * cursor->word) & SIM_MASK);
+		AD5932_SimEnter(sweep, cursor->step + 1, cursor->stepEnd, phase, cursor);
+	}
+	if (cursor->step > sweep->increment)
+		return false;
+
+	cursor->phase = (u32)((cursor->phase + ((cycle - cursor->cycle) & SIM_MASK) * cursor->word) & SIM_MASK);
+	cursor->cycle = cycle;
+	return true;
+}
+
+// ....................................................................................................................
+// @brief:      Accumulator at the start of a step. O(1) for MCLK based intervals, O(step) for output based ones.
+// @param[in]:  Sweep
+// @param[in]:  Step index, clamped to NINCR + 1 (the end of the sweep)
+// @return:     Accumulator, 24 bit
+// ....................................................................................................................
+u32 AD5932_SimPhase(const AD5932Sweep_t* sweep, u32 step)
+{
+	AD5932SimCursor_t cursor;
+	u64 k, base, ramp;
+
+	if (step > (u32)sweep->increment + 1)
+		step = sweep->increment + 1;
+
+	if (sweep->incrementBase != WAVE_OUT_BASED)
+	{
+		k = step;
+		base = (k * sweep->startWord) & SIM_MASK;
+		ramp = (((k * (k - 1) / 2) & SIM_MASK) * sweep->deltaWord) & SIM_MASK;
+		if (step == 0)
+			ramp = 0;
+		base = (sweep->sweepType == DECREMENTAL_SWEEP) ? base - ramp : base + ramp;
+		return (u32)(((base & SIM_MASK) * sweep->intervall) & SIM_MASK);
+	}
+
+	AD5932_SimEnter(sweep, 0, 0, 0, &cursor);
+	while ((cursor.step < step) && (cursor.stepEnd != AD5932_SIM_END))
+		AD5932_SimAdvance(sweep, cursor.stepEnd, &cursor);
+	return cursor.phase;
+}
+
+// ....................................................................................................................
+// @brief:      Start cycle of a step. O(1) for MCLK based intervals, O(step) for output based ones.
+// @param[in]:  Sweep
+// @param[in]:  Step index, clamped to NINCR + 1 (the end of the sweep)
+// @return:     MCLK cycles from the CTRL trigger, AD5932_SIM_END if a step before never ends (zero tuning word)
+// ....................................................................................................................
+u64 AD5932_SimStepCycle(const AD5932Sweep_t* sweep, u32 step)
+{
+	AD5932SimCursor_t cursor;
+
+	if (step > (u32)sweep->increment + 1)
+		step = sweep->increment + 1;
+
+	if (sweep->incrementBase != WAVE_OUT_BASED)
+		return (u64)step * sweep->intervall;
+
+	AD5932_SimEnter(sweep, 0, 0, 0, &cursor);
+	while (cursor.step < step)
+	{
+		if (cursor.stepEnd == AD5932_SIM_END)
+			return AD5932_SIM_END;
+		AD5932_SimAdvance(sweep, cursor.stepEnd, &cursor);
+	}
+	return cursor.cycle;
+}
+
+// ....................................................................................................................
+// @brief:      Sets a cursor to any cycle of a sweep, without replaying the samples before it
+// @param[in]:  Sweep
+// @param[in]:  MCLK cycle from the CTRL trigger
+// @param[out]: Cursor
+// @return:     false if the cycle is after the end of the sweep
+// ....................................................................................................................
+bool AD5932_SimSeek(const AD5932Sweep_t* sweep, u64 cycle, AD5932SimCursor_t* cursor)
+{
+	u64 step = 0;
+
+	if ((sweep->incrementBase != WAVE_OUT_BASED) && (sweep->intervall != 0))
+	{
+		step = cycle / sweep->intervall;
+		if (step > (u64)sweep->increment + 1)
+			step = sweep->increment + 1;
+	}
+	AD5932_SimEnter(sweep, (u32)step, step * sweep->intervall, AD5932_SimPhase(sweep, (u32)step), cursor);
+	return AD5932_SimAdvance(sweep, cycle, cursor);
+}
+
+// ....................................................................................................................
+// @brief:      Renders DAC samples of a sweep. Any range can be rendered on its own, the result is the same as the
+//				range of a render from sample 0.
+// @param[in]:  Sweep
+// @param[in]:  SINE_OUT / TRIANGLE_OUT
+// @param[in]:  First sample, sample n is taken at MCLK cycle n * decimation
+// @param[in]:  Number of samples
+// @param[in]:  MCLK cycles per sample, 1 for the full DAC rate
+// @param[out]: DAC codes
+// @return:     Samples rendered, fewer than count at the end of the sweep
+// ....................................................................................................................
+u32 AD5932_SimRender(const AD5932Sweep_t* sweep, RegBits_t WAVE_TYPE, u64 first, u32 count, u32 decimation, u16* out)
+{
+	AD5932SimCursor_t cursor;
+	u64 cycle;
+	u32 i;
+
+	if (decimation == 0)
+		decimation = 1;
+
+	cycle = first * decimation;
+	if ((count == 0) || !AD5932_SimSeek(sweep, cycle, &cursor))
+		return 0;
+
+	for (i = 0; i < count; i++)
+	{
+		if ((i != 0) && !AD5932_SimAdvance(sweep, cycle, &cursor))
+			break;
+		out[i] = AD5932_SimDac(cursor.phase, WAVE_TYPE);
+		cycle += decimation;
+	}
+	return i;
+}
+
+#endif
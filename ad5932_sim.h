@@ -0,0 +1,38 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_sim.h
+// @brief:      AD5932 output model: phase accumulator jump-ahead and DAC sample rendering of programmed sweeps
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+#ifndef __AD5932_SIM_H
+#define __AD5932_SIM_H
+
+#include "defs.h"
+#include "ad5932.h"
+
+#define AD5932_SIM_PHASE_BITS	12			//accumulator bits addressing the sine ROM
+#define AD5932_SIM_DAC_BITS		10			//DAC resolution
+#define AD5932_SIM_END			0xFFFFFFFFFFFFFFFFULL	//cycle of a step that never ends
+
+//position in a sweep, in MCLK cycles from the CTRL trigger
+typedef struct
+{
+	u64 cycle;				//MCLK cycle
+	u64 stepEnd;			//first cycle of the next step, AD5932_SIM_END if the step never ends
+	u32 step;				//0..NINCR, NINCR + 1 after the end of the sweep
+	u32 word;				//tuning word of the step
+	u32 phase;				//accumulator at the cycle, 24 bit
+} AD5932SimCursor_t;
+
+void AD5932_SimInit(void);
+u16 AD5932_SimDac(u32 phase, RegBits_t WAVE_TYPE);
+u32 AD5932_SimPhase(const AD5932Sweep_t* sweep, u32 step);
+u64 AD5932_SimStepCycle(const AD5932Sweep_t* sweep, u32 step);
+bool AD5932_SimSeek(const AD5932Sweep_t* sweep, u64 cycle, AD5932SimCursor_t* cursor);
+bool AD5932_SimAdvance(const AD5932Sweep_t* sweep, u64 cycle, AD5932SimCursor_t* cursor);
+u32 AD5932_SimRender(const AD5932Sweep_t* sweep, RegBits_t WAVE_TYPE, u64 first, u32 count, u32 decimation, u16* out);
+
+#endif
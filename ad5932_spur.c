@@ -0,0 +1,239 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_spur.c
+// @brief:      Spectral purity of the AD5932 output model: windowed FFT, SFDR, THD and spur list of a fixed frequency
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+// --------------------------------------------------------------------------------------------------------------------
+// Includes
+// --------------------------------------------------------------------------------------------------------------------
+
+#include "main.h"
+#include "config.h"
+#if USE_AD5932 && !defined(MCU_FAMILY)
+
+#include <math.h>
+#include "ad5932_spur.h"
+#include "ad5932_sim.h"
+
+// --------------------------------------------------------------------------------------------------------------------
+// Defines
+// --------------------------------------------------------------------------------------------------------------------
+
+#define SPUR_PI				3.14159265358979323846
+#define SPUR_LOBE			4				//half width of the Blackman-Harris main lobe in bins
+#define SPUR_SEARCH			2				//bins searched around an expected tone for its peak
+#define SPUR_FLOOR			1e-20			//power ratio floor, -200 dB
+#define SPUR_MID_SCALE		(((1 << AD5932_SIM_DAC_BITS) - 1) / 2.0f)
+
+// --------------------------------------------------------------------------------------------------------------------
+// Notes
+// --------------------------------------------------------------------------------------------------------------------
+
+//Host only, as ad5932_sim.c: the file is empty in firmware builds (MCU_FAMILY defined).
+//The output is rendered at the DAC rate (one sample per MCLK cycle) with the phase truncation and the DAC
+//quantization of ad5932_sim.c, so the spurs are the ones of the digital signal chain, before the DAC analog errors
+//and the reconstruction filter. Everything above MCLK / 2 folds back, so the spur frequencies are given folded too.
+//The samples are weighted with a 4 term Blackman-Harris window (-92 dB sidelobes, well under the ~-70 dBc spurs of a
+//10 bit DAC), so the tuning word does not have to be coherent with the FFT size. The power of a tone is the sum of
+//its main lobe bins, which does not depend on where the tone falls between two bins.
+//SFDR is the carrier to the largest other tone (harmonic or not), THD counts harmonics 2..AD5932_SPUR_HARMONICS at
+//their folded frequencies, a tone that more harmonics fold onto is counted once. The tuning word is truncated as
+//AD5932_FrequencyToWord() programs it. The work buffer is the only state: one buffer per thread analyzes different
+//frequencies in parallel. Call AD5932_SimInit() before starting the threads.
+
+// --------------------------------------------------------------------------------------------------------------------
+// Functions
+// --------------------------------------------------------------------------------------------------------------------
+
+// ....................................................................................................................
+// @brief:      In place radix-2 complex FFT
+// @param[in]:  Real and imaginary parts
+// @param[in]:  log2 of the size
+// ....................................................................................................................
+static void AD5932_SpurFFT(float* re, float* im, u16 log2Size)
+{
+	u32 size = 1UL << log2Size;
+	u32 i, j, k, half, len;
+	double wr, wi, ur, ui, t;
+	float tr, ti;
+
+	//bit reversed order
+	for (i = 1, j = 0; i < size; i++)
+	{
+		for (k = size >> 1; j & k; k >>= 1)
+			j ^= k;
+		j |= k;
+		if (i < j)
+		{
+			tr = re[i]; re[i] = re[j]; re[j] = tr;
+			ti = im[i]; im[i] = im[j]; im[j] = ti;
+		}
+	}
+
+	for (len = 2; len <= size; len <<= 1)
+	{
+		half = len >> 1;
+		wr = cos(-2.0 * SPUR_PI / len);
+		wi = sin(-2.0 * SPUR_PI / len);
+		ur = 1.0;
+		ui = 0.0;
+		for (j = 0; j < half; j++)
+		{
+			for (i = j; i < size; i += len)
+			{
+				k = i + half;
+				tr = (float)(re[k] * ur - im[k] * ui);
+				ti = (float)(re[k] * ui + im[k] * ur);
+				re[k] = re[i] - tr;
+				im[k] = im[i] - ti;
+				re[i] += tr;
+				im[i] += ti;
+			}
+			t = ur * wr - ui * wi;
+			ui = ur * wi + ui * wr;
+			ur = t;
+		}
+	}
+}
+
+// ....................................................................................................................
+// @brief:      Power of a tone: the peak near a bin and its main lobe
+// @param[in]:  Power spectrum, bins 0..size / 2
+// @param[in]:  Last bin (size / 2)
+// @param[in]:  Expected bin
+// @param[in]:  Bins searched around it for the peak
+// @param[out]: Peak bin
+// @return:     Power
+// ....................................................................................................................
+static double AD5932_SpurTone(const float* power, u32 last, u32 bin, u32 search, u32* peak)
+{
+	u32 i, from, to;
+	double sum = 0.0;
+
+	from = (bin > search) ? bin - search : 0;
+	to = (bin + search < last) ? bin + search : last;
+	*peak = from;
+	for (i = from; i <= to; i++)
+		if (power[i] > power[*peak])
+			*peak = i;
+
+	from = (*peak > SPUR_LOBE) ? *peak - SPUR_LOBE : 0;
+	to = (*peak + SPUR_LOBE < last) ? *peak + SPUR_LOBE : last;
+	for (i = from; i <= to; i++)
+		sum += power[i];
+	return sum;
+}
+
+// ....................................................................................................................
+// @brief:      Bin of a frequency, folded into 0..MCLK / 2
+// ....................................................................................................................
+static u32 AD5932_SpurBin(double frequency, u32 mclk, u32 size)
+{
+	frequency = fmod(frequency, (double)mclk);
+	if (frequency > mclk / 2.0)
+		frequency = mclk - frequency;
+	return (u32)(frequency * size / mclk + 0.5);
+}
+
+// ....................................................................................................................
+// @brief:      Spectral purity of a programmed frequency, as the output model renders it
+// @param[in]:  Frequency in Hz
+// @param[in]:  MCLK in Hz
+// @param[in]:  SINE_OUT / TRIANGLE_OUT
+// @param[in]:  log2 of the FFT size, AD5932_SPUR_MIN_LOG2..AD5932_SPUR_MAX_LOG2
+// @param[in]:  Work buffer of 2 * 2^log2Size floats, not shared with other threads
+// @param[out]: Result
+// @return:     0, or AD5932_PARAM_ERROR if the frequency is 0 or above MCLK / 2, the size is out of range or a pointer is NULL
+// ....................................................................................................................
+s32 AD5932_SpurAnalyze(u32 frequency, u32 mclk, RegBits_t WAVE_TYPE, u16 log2Size, float* work, AD5932SpurResult_t* result)
+{
+	float* re = work;
+	float* im;
+	u32 size, last, i, j, carrier, peak, bin, counted = 0;
+	u32 harmonic[AD5932_SPUR_HARMONICS];
+	u32 phase = 0;
+	double c1, c2, c3, p1, ph, harmonics = 0.0;
+	float level;
+
+	if ((mclk == 0) || (work == NULL) || (result == NULL) || (log2Size < AD5932_SPUR_MIN_LOG2) || (log2Size > AD5932_SPUR_MAX_LOG2))
+		return AD5932_PARAM_ERROR;
+
+	result->frequency = frequency;
+	result->word = AD5932_FactorToWord(frequency, ((u64)AD5932_ACCU_RESOLUTION << 32) / mclk, mclk);
+	if ((result->word == 0) || (result->word >= AD5932_ACCU_RESOLUTION / 2))
+		return AD5932_PARAM_ERROR;
+	result->actual = (double)result->word * mclk / AD5932_ACCU_RESOLUTION;
+	result->spurCount = 0;
+
+	size = 1UL << log2Size;
+	last = size / 2;
+	im = work + size;
+	AD5932_SimInit();
+
+	//render, remove the mid scale and window (periodic form, the window of the FFT period)
+	for (i = 0; i < size; i++)
+	{
+		c1 = cos(2.0 * SPUR_PI * i / size);
+		c2 = 2.0 * c1 * c1 - 1.0;			//cos(2a), cos(3a) without more cos() calls
+		c3 = 2.0 * c1 * c2 - c1;
+		re[i] = ((float)AD5932_SimDac(phase, WAVE_TYPE) - SPUR_MID_SCALE) * (float)(0.35875 - 0.48829 * c1 + 0.14128 * c2 - 0.01168 * c3);
+		im[i] = 0.0f;
+		phase = (phase + result->word) & (AD5932_ACCU_RESOLUTION - 1);
+	}
+	AD5932_SpurFFT(re, im, log2Size);
+
+	//power spectrum over re[0..size / 2]
+	for (i = 0; i <= last; i++)
+		re[i] = re[i] * re[i] + im[i] * im[i];
+
+	p1 = AD5932_SpurTone(re, last, AD5932_SpurBin(result->actual, mclk, size), SPUR_SEARCH, &carrier);
+	if (p1 <= 0.0)
+		return AD5932_PARAM_ERROR;
+
+	for (i = 2; i <= AD5932_SPUR_HARMONICS; i++)
+	{
+		bin = AD5932_SpurBin(result->actual * i, mclk, size);
+		if ((bin + 2 * SPUR_LOBE >= carrier) && (bin <= carrier + 2 * SPUR_LOBE))
+			continue;		//folds onto the carrier
+		ph = AD5932_SpurTone(re, last, bin, SPUR_SEARCH, &peak);
+
+		//harmonics that fold onto the lobe of one already counted are the same tone
+		for (j = 0; j < counted; j++)
+			if ((peak + 2 * SPUR_LOBE >= harmonic[j]) && (peak <= harmonic[j] + 2 * SPUR_LOBE))
+				break;
+		if (j < counted)
+			continue;
+		harmonic[counted++] = peak;
+		harmonics += ph;
+	}
+	result->thd = (float)(10.0 * log10((harmonics / p1 > SPUR_FLOOR) ? harmonics / p1 : SPUR_FLOOR));
+
+	//largest peaks away from DC and the carrier, sorted by insertion. A bin is a spur if it is the peak of its own
+	//main lobe, so the skirt of a tone is not listed again. Its lobe stays off the carrier lobe.
+	for (i = SPUR_LOBE + 1; i < last; i++)
+	{
+		if ((i + 2 * SPUR_LOBE >= carrier) && (i <= carrier + 2 * SPUR_LOBE))
+			continue;
+		ph = AD5932_SpurTone(re, last, i, SPUR_LOBE, &peak) / p1;
+		if (peak != i)
+			continue;
+		level = (float)(10.0 * log10((ph > SPUR_FLOOR) ? ph : SPUR_FLOOR));
+		if ((result->spurCount == AD5932_SPUR_COUNT) && (level <= result->spur[AD5932_SPUR_COUNT - 1].level))
+			continue;
+
+		j = (result->spurCount < AD5932_SPUR_COUNT) ? result->spurCount++ : AD5932_SPUR_COUNT - 1;
+		for (; (j > 0) && (result->spur[j - 1].level < level); j--)
+			result->spur[j] = result->spur[j - 1];
+		result->spur[j].frequency = (u32)(((u64)i * mclk + size / 2) / size);
+		result->spur[j].level = level;
+	}
+
+	result->sfdr = (result->spurCount != 0) ? -result->spur[0].level : (float)(-10.0 * log10(SPUR_FLOOR));
+	return 0;
+}
+
+#endif
@@ -0,0 +1,44 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_spur.h
+// @brief:      Spectral purity of the AD5932 output model: windowed FFT, SFDR, THD and spur list of a fixed frequency
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+#ifndef __AD5932_SPUR_H
+#define __AD5932_SPUR_H
+
+#include "defs.h"
+#include "ad5932.h"
+
+#ifndef AD5932_SPUR_COUNT
+	#define AD5932_SPUR_COUNT		8		//largest spurs reported
+#endif
+#define AD5932_SPUR_HARMONICS		5		//harmonics 2..n counted in THD
+#define AD5932_SPUR_MIN_LOG2		8		//FFT size limits
+#define AD5932_SPUR_MAX_LOG2		22
+
+//one spur
+typedef struct
+{
+	u32 frequency;			//Hz, folded into 0..MCLK / 2
+	float level;			//dBc, relative to the carrier
+} AD5932Spur_t;
+
+//spectral purity of one programmed frequency
+typedef struct
+{
+	u32 frequency;			//programmed frequency in Hz
+	u32 word;				//tuning word
+	double actual;			//output frequency of the tuning word in Hz
+	float sfdr;				//spurious free dynamic range in dB, carrier to largest spur
+	float thd;				//total harmonic distortion in dB, harmonics 2..AD5932_SPUR_HARMONICS to carrier
+	u16 spurCount;
+	AD5932Spur_t spur[AD5932_SPUR_COUNT];	//largest first
+} AD5932SpurResult_t;
+
+s32 AD5932_SpurAnalyze(u32 frequency, u32 mclk, RegBits_t WAVE_TYPE, u16 log2Size, float* work, AD5932SpurResult_t* result);
+
+#endif
@@ -0,0 +1,138 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_trace.c
+// @brief:      Compile time optional timing trace of the AD5932 driver (binary events, Chrome / Perfetto on the host)
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+// --------------------------------------------------------------------------------------------------------------------
+// Includes
+// --------------------------------------------------------------------------------------------------------------------
+
+#include "main.h"
+#include "config.h"
+#if USE_AD5932 && AD5932_TRACE
+
+#include "ad5932.h"
+#include "ad5932_trace.h"
+
+// --------------------------------------------------------------------------------------------------------------------
+// Notes
+// --------------------------------------------------------------------------------------------------------------------
+
+//Build the driver with AD5932_TRACE = 1 to get the trace points: AD5932_SweepGenerator() begin / end, command build,
+//bus wait, every SPI word, the CTRL pulses and the SYNCOUT edges seen by the capture. Without it the trace points are
+//empty macros and this file is left out (no buffer in RAM), the driver has no extra code at all. Set AD5932_TRACE in
+//config.h or on the command line, so this file sees it too.
+//An event is 8 bytes with a time stamp of the trace clock, which should be much finer than the us time base (a word
+//takes ~1.6 us at 10 MHz SCLK): the DWT cycle counter of the Cortex-M3 is the usual choice.
+//The buffer keeps the first AD5932_TRACE_EVENTS events after AD5932_TraceStart(), the later ones are only counted,
+//so a full reprogramming sequence is not overwritten by what comes after it. AD5932_TraceDump() writes the header and
+//the events (raw, little endian as the MCU), tools/ad5932_trace2json turns the dump into a Chrome / Perfetto trace.
+
+// --------------------------------------------------------------------------------------------------------------------
+// Variables
+// --------------------------------------------------------------------------------------------------------------------
+
+AD5932TraceEvent_t ad5932TraceBuffer[AD5932_TRACE_EVENTS];
+volatile u32 ad5932TraceCount;
+volatile u32 ad5932TraceDropped;
+AD5932_TraceClock_t ad5932TraceClock;
+u32 ad5932TraceTicksPerUs;
+
+// --------------------------------------------------------------------------------------------------------------------
+// Functions
+// --------------------------------------------------------------------------------------------------------------------
+
+// ....................................................................................................................
+// @brief:      Clears the buffer and starts recording
+// @param[in]:  Trace clock
+// @param[in]:  Trace clock ticks per us
+// @return:     none
+// ....................................................................................................................
+void AD5932_TraceStart(AD5932_TraceClock_t clock, u32 ticksPerUs)
+{
+	ad5932TraceClock = NULL;
+	ad5932TraceCount = 0;
+	ad5932TraceDropped = 0;
+	ad5932TraceTicksPerUs = ticksPerUs;
+	ad5932TraceClock = clock;
+}
+
+// ....................................................................................................................
+// @brief:      Stops recording, the buffer is kept for AD5932_TraceDump()
+// @param[in]:  none
+// @return:     none
+// ....................................................................................................................
+void AD5932_TraceStop(void)
+{
+	ad5932TraceClock = NULL;
+}
+
+// ....................................................................................................................
+// @brief:      Records an event. Called by the AD5932_TRACE_EVENT() trace points, can be called from interrupts.
+// @param[in]:  AD5932_TraceType_t
+// @param[in]:  AD5932_TR_BEGIN / AD5932_TR_END / AD5932_TR_INSTANT
+// @param[in]:  Argument of the event
+// @return:     none
+// ....................................................................................................................
+void AD5932_TraceEvent(u08 type, u08 phase, u16 arg)
+{
+	AD5932TraceEvent_t* e;
+	u32 time;
+	u32 primask;
+
+	if (ad5932TraceClock == NULL)
+		return;
+
+	AD5932_CRITICAL_ENTER(primask);
+	time = ad5932TraceClock();
+	if (ad5932TraceCount >= AD5932_TRACE_EVENTS)
+	{
+		ad5932TraceDropped++;
+		AD5932_CRITICAL_EXIT(primask);
+		return;
+	}
+	e = &ad5932TraceBuffer[ad5932TraceCount++];
+	AD5932_CRITICAL_EXIT(primask);
+
+	e->time = (uint32_t)time;
+	e->type = type;
+	e->phase = phase;
+	e->arg = arg;
+}
+
+// ....................................................................................................................
+// @brief:      Number of recorded events
+// @param[in]:  none
+// @return:     Events in the buffer
+// ....................................................................................................................
+u32 AD5932_TraceCount(void)
+{
+	return ad5932TraceCount;
+}
+
+// ....................................................................................................................
+// @brief:      Writes the header and the recorded events. Stop the trace first.
+// @param[in]:  Write function and its context (UART, USB, file)
+// @return:     false if a write failed
+// ....................................................................................................................
+bool AD5932_TraceDump(AD5932_TraceWrite_t write, void* context)
+{
+	AD5932TraceHeader_t header;
+
+	header.magic = AD5932_TRACE_MAGIC;
+	header.version = AD5932_TRACE_VERSION;
+	header.eventSize = sizeof(AD5932TraceEvent_t);
+	header.ticksPerUs = ad5932TraceTicksPerUs;
+	header.count = ad5932TraceCount;
+	header.dropped = ad5932TraceDropped;
+
+	if (!write(context, &header, sizeof(header)))
+		return false;
+	return write(context, ad5932TraceBuffer, header.count * sizeof(AD5932TraceEvent_t));
+}
+
+#endif
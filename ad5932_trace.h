@@ -0,0 +1,90 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_trace.h
+// @brief:      Compile time optional timing trace of the AD5932 driver (binary events, Chrome / Perfetto on the host)
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+#ifndef __AD5932_TRACE_H
+#define __AD5932_TRACE_H
+
+#include <stdint.h>
+#include "defs.h"
+
+#ifndef AD5932_TRACE
+	#define AD5932_TRACE			0		//1: trace points are compiled into the driver
+#endif
+
+#ifndef AD5932_TRACE_EVENTS
+	#define AD5932_TRACE_EVENTS		1024	//events kept
+#endif
+
+#define AD5932_TRACE_MAGIC			0x54353941	//"AD5T"
+#define AD5932_TRACE_VERSION		1
+
+//traced events
+typedef enum _AD5932_TraceType_t
+{
+	AD5932_TR_SWEEP			= 0,	//AD5932_SweepGenerator() call
+	AD5932_TR_VALIDATE,				//sweep parameter validation (AD5932_ValidateSweep())
+	AD5932_TR_BUS_WAIT,				//waiting for the bus (arbiter) / bus found busy
+	AD5932_TR_SPI_WORD,				//one command word, FSYNC low to high, arg: the word
+	AD5932_TR_CTRL,					//CTRL pulse
+	AD5932_TR_SYNCOUT,				//SYNCOUT edge, arg: step
+	AD5932_TR_TYPES
+} AD5932_TraceType_t;
+
+//event phases, as in the Chrome trace format
+#define AD5932_TR_BEGIN				'B'
+#define AD5932_TR_END				'E'
+#define AD5932_TR_INSTANT			'i'
+
+//The dump is read on the host, where the integer types of defs.h can be wider, so the dumped structs use fixed width
+//types.
+
+//one event, 8 bytes
+typedef struct
+{
+	uint32_t time;			//trace clock ticks
+	uint8_t type;			//AD5932_TraceType_t
+	uint8_t phase;			//AD5932_TR_BEGIN / END / INSTANT
+	uint16_t arg;
+} AD5932TraceEvent_t;
+
+//header of the binary dump, followed by the events, 20 bytes
+typedef struct
+{
+	uint32_t magic;			//AD5932_TRACE_MAGIC
+	uint16_t version;		//AD5932_TRACE_VERSION
+	uint16_t eventSize;		//sizeof(AD5932TraceEvent_t)
+	uint32_t ticksPerUs;	//trace clock
+	uint32_t count;			//events in the dump
+	uint32_t dropped;		//events lost because the buffer was full
+} AD5932TraceHeader_t;
+
+//compile time size checks of the format: the build fails on a negative array size
+typedef char AD5932TraceEventSize_t[(sizeof(AD5932TraceEvent_t) == 8) ? 1 : -1];
+typedef char AD5932TraceHeaderSize_t[(sizeof(AD5932TraceHeader_t) == 20) ? 1 : -1];
+
+//trace clock, free running (ie. DWT cycle counter)
+typedef u32 (*AD5932_TraceClock_t)(void);
+
+//output of the dump, returns false on error
+typedef bool (*AD5932_TraceWrite_t)(void* context, const void* data, u32 length);
+
+#if AD5932_TRACE
+	#define AD5932_TRACE_EVENT(type, phase, arg)	AD5932_TraceEvent((type), (phase), (arg))
+#else
+	#define AD5932_TRACE_EVENT(type, phase, arg)	((void)0)
+#endif
+
+//only with AD5932_TRACE = 1
+void AD5932_TraceStart(AD5932_TraceClock_t clock, u32 ticksPerUs);
+void AD5932_TraceStop(void);
+void AD5932_TraceEvent(u08 type, u08 phase, u16 arg);
+u32 AD5932_TraceCount(void);
+bool AD5932_TraceDump(AD5932_TraceWrite_t write, void* context);
+
+#endif
@@ -0,0 +1,219 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_vcd.c
+// @brief:      Incremental VCD (value change dump) writer of the AD5932 signals, for GTKWave
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+// --------------------------------------------------------------------------------------------------------------------
+// Includes
+// --------------------------------------------------------------------------------------------------------------------
+
+#include "main.h"
+#include "config.h"
+#if USE_AD5932
+
+#include <string.h>
+#include "ad5932_vcd.h"
+
+// --------------------------------------------------------------------------------------------------------------------
+// Notes
+// --------------------------------------------------------------------------------------------------------------------
+
+//The writer produces the VCD text on the fly: the header at AD5932_VcdInit(), then a "#<ns>" time stamp and the
+//"<level><id>" lines of the changes. Only real changes are written, and a time stamp only before the first change at
+//that time. The text goes through a fixed buffer to the write function in AD5932_VCD_BUFFER sized pieces, so a long
+//sweep is streamed at the speed of the output and the trace is never kept in memory.
+//Times are in ns and must not go backwards, an earlier time is taken as the last one.
+//AD5932_VcdWord() draws a 16 bit SPI word on SCLK / SDATA as the AD5932 sees it: SCLK idles high, the data bit is set
+//at the rising edge and the chip takes it at the falling one, MSB first.
+
+// --------------------------------------------------------------------------------------------------------------------
+// Variables
+// --------------------------------------------------------------------------------------------------------------------
+
+//VCD identifier and name of the signals
+static const char ad5932VcdId[AD5932_VCD_SIGNALS] = { '!', '"', '#', '$', '%', '&', '\'', '(' };
+static const char* const ad5932VcdName[AD5932_VCD_SIGNALS] = { "SCLK", "SDATA", "FSYNC", "CTRL", "INTERRUPT", "STANDBY", "SYNCOUT", "MSBOUT" };
+
+// --------------------------------------------------------------------------------------------------------------------
+// Functions
+// --------------------------------------------------------------------------------------------------------------------
+
+// ....................................................................................................................
+// @brief:      Hands the buffer to the write function
+// @param[in]:  none
+// @return:     false if the write failed (now or earlier)
+// ....................................................................................................................
+bool AD5932_VcdFlush(AD5932Vcd_t* vcd)
+{
+	if (!vcd->error && (vcd->used > 0))
+		vcd->error = !vcd->write(vcd->context, vcd->buffer, vcd->used);
+	vcd->used = 0;
+	return !vcd->error;
+}
+
+// ....................................................................................................................
+// @brief:      Appends text to the buffer, writes it out when full
+// @param[in]:  Text, length
+// @return:     none
+// ....................................................................................................................
+static void AD5932_VcdPut(AD5932Vcd_t* vcd, const char* text, u32 length)
+{
+	u32 chunk;
+
+	while (length > 0)
+	{
+		chunk = AD5932_VCD_BUFFER - vcd->used;
+		if (chunk > length)
+			chunk = length;
+		memcpy(&vcd->buffer[vcd->used], text, chunk);
+		vcd->used += chunk;
+		text += chunk;
+		length -= chunk;
+		if (vcd->used == AD5932_VCD_BUFFER)
+			AD5932_VcdFlush(vcd);
+	}
+}
+
+// ....................................................................................................................
+// @brief:      Appends a zero terminated string
+// @param[in]:  String
+// @return:     none
+// ....................................................................................................................
+static void AD5932_VcdPuts(AD5932Vcd_t* vcd, const char* text)
+{
+	AD5932_VcdPut(vcd, text, strlen(text));
+}
+
+// ....................................................................................................................
+// @brief:      Appends a "#<time>" line
+// @param[in]:  Time in ns
+// @return:     none
+// ....................................................................................................................
+static void AD5932_VcdTime(AD5932Vcd_t* vcd, u64 time)
+{
+	char text[24];
+	u08 i = sizeof(text);
+
+	text[--i] = '\n';
+	do
+	{
+		text[--i] = '0' + (char)(time % 10);
+		time /= 10;
+	} while (time != 0);
+	text[--i] = '#';
+	AD5932_VcdPut(vcd, &text[i], sizeof(text) - i);
+}
+
+// ....................................................................................................................
+// @brief:      Starts the dump: writes the header and the initial levels at time 0
+// @param[in]:  Write function and its context
+// @param[in]:  Initial levels, bit n is the level of signal n (AD5932_VcdSignal_t)
+// @return:     false if the write failed
+// ....................................................................................................................
+bool AD5932_VcdInit(AD5932Vcd_t* vcd, AD5932_VcdWrite_t write, void* context, u08 initial)
+{
+	char line[4] = { '0', 0, '\n', 0 };
+	u08 i;
+
+	memset(vcd, 0, sizeof(*vcd));
+	vcd->write = write;
+	vcd->context = context;
+
+	AD5932_VcdPuts(vcd, "$version AD5932 driver $end\n$timescale 1ns $end\n$scope module ad5932 $end\n");
+	for (i = 0; i < AD5932_VCD_SIGNALS; i++)
+	{
+		AD5932_VcdPuts(vcd, "$var wire 1 ");
+		AD5932_VcdPut(vcd, &ad5932VcdId[i], 1);
+		AD5932_VcdPuts(vcd, " ");
+		AD5932_VcdPuts(vcd, ad5932VcdName[i]);
+		AD5932_VcdPuts(vcd, " $end\n");
+	}
+	AD5932_VcdPuts(vcd, "$upscope $end\n$enddefinitions $end\n#0\n$dumpvars\n");
+	for (i = 0; i < AD5932_VCD_SIGNALS; i++)
+	{
+		vcd->level[i] = (initial >> i) & 1;
+		line[0] = '0' + vcd->level[i];
+		line[1] = ad5932VcdId[i];
+		AD5932_VcdPut(vcd, line, 3);
+	}
+	AD5932_VcdPuts(vcd, "$end\n");
+	vcd->timeWritten = true;
+
+	return AD5932_VcdFlush(vcd);
+}
+
+// ....................................................................................................................
+// @brief:      Records a level of a signal, written only if it changes
+// @param[in]:  Time in ns
+// @param[in]:  Signal
+// @param[in]:  Level
+// @return:     none
+// ....................................................................................................................
+void AD5932_VcdSet(AD5932Vcd_t* vcd, u64 time, AD5932_VcdSignal_t signal, bool level)
+{
+	char line[3];
+
+	if ((signal >= AD5932_VCD_SIGNALS) || (vcd->level[signal] == (u08)(level != 0)))
+		return;
+
+	if (time > vcd->time)
+	{
+		vcd->time = time;
+		vcd->timeWritten = false;
+	}
+	if (!vcd->timeWritten)
+	{
+		AD5932_VcdTime(vcd, vcd->time);
+		vcd->timeWritten = true;
+	}
+
+	vcd->level[signal] = (level != 0);
+	line[0] = '0' + vcd->level[signal];
+	line[1] = ad5932VcdId[signal];
+	line[2] = '\n';
+	AD5932_VcdPut(vcd, line, 3);
+}
+
+// ....................................................................................................................
+// @brief:      Draws a 16 bit SPI word on SCLK / SDATA, MSB first. FSYNC is not touched.
+// @param[in]:  Start time in ns
+// @param[in]:  Command word
+// @param[in]:  SCLK in Hz
+// @return:     End time of the word in ns
+// ....................................................................................................................
+u64 AD5932_VcdWord(AD5932Vcd_t* vcd, u64 time, u16 word, u32 sclk)
+{
+	u64 half = (sclk != 0) ? (500000000ULL + sclk - 1) / sclk : 1;
+	u08 bit;
+
+	//MSB first: the u08 counter is tested before the decrement, so the body sees 15..0; the wrap to 255 after the
+	//last (false) test is never used
+	for (bit = 16; bit-- > 0; )
+	{
+		AD5932_VcdSet(vcd, time, AD5932_VCD_SCLK, true);
+		AD5932_VcdSet(vcd, time, AD5932_VCD_SDATA, (word >> bit) & 1);
+		time += half;
+		AD5932_VcdSet(vcd, time, AD5932_VCD_SCLK, false);
+		time += half;
+	}
+	AD5932_VcdSet(vcd, time, AD5932_VCD_SCLK, true);
+	return time;
+}
+
+// ....................................................................................................................
+// @brief:      Closes the dump with a last time stamp and writes out the buffer
+// @param[in]:  End time in ns
+// @return:     false if any write failed
+// ....................................................................................................................
+bool AD5932_VcdFinish(AD5932Vcd_t* vcd, u64 time)
+{
+	if (time > vcd->time)
+		AD5932_VcdTime(vcd, time);
+	return AD5932_VcdFlush(vcd);
+}
+
+#endif
@@ -0,0 +1,54 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_vcd.h
+// @brief:      Incremental VCD (value change dump) writer of the AD5932 signals, for GTKWave
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+#ifndef __AD5932_VCD_H
+#define __AD5932_VCD_H
+
+#include "defs.h"
+
+#ifndef AD5932_VCD_BUFFER
+	#define AD5932_VCD_BUFFER		4096	//bytes buffered before a write
+#endif
+
+//dumped signals
+typedef enum _AD5932_VcdSignal_t
+{
+	AD5932_VCD_SCLK			= 0,
+	AD5932_VCD_SDATA,
+	AD5932_VCD_FSYNC,
+	AD5932_VCD_CTRL,
+	AD5932_VCD_INT,
+	AD5932_VCD_STDBY,
+	AD5932_VCD_SYNCOUT,
+	AD5932_VCD_MSBOUT,
+	AD5932_VCD_SIGNALS
+} AD5932_VcdSignal_t;
+
+//output of the writer (file, UART, SD card), returns false on error
+typedef bool (*AD5932_VcdWrite_t)(void* context, const char* data, u32 length);
+
+typedef struct
+{
+	AD5932_VcdWrite_t write;
+	void* context;
+	u64 time;						//ns, last time stamp written
+	bool timeWritten;				//time stamp of the current time is out
+	bool error;						//a write failed, the rest is dropped
+	u08 level[AD5932_VCD_SIGNALS];	//current levels
+	u32 used;						//bytes in the buffer
+	char buffer[AD5932_VCD_BUFFER];
+} AD5932Vcd_t;
+
+bool AD5932_VcdInit(AD5932Vcd_t* vcd, AD5932_VcdWrite_t write, void* context, u08 initial);
+void AD5932_VcdSet(AD5932Vcd_t* vcd, u64 time, AD5932_VcdSignal_t signal, bool level);
+u64 AD5932_VcdWord(AD5932Vcd_t* vcd, u64 time, u16 word, u32 sclk);
+bool AD5932_VcdFlush(AD5932Vcd_t* vcd);
+bool AD5932_VcdFinish(AD5932Vcd_t* vcd, u64 time);
+
+#endif
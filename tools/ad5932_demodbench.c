@@ -0,0 +1,156 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_demodbench.c
+// @brief:      Host tool: throughput and accuracy benchmark of the per step Goertzel demodulator
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+// --------------------------------------------------------------------------------------------------------------------
+// Notes
+// --------------------------------------------------------------------------------------------------------------------
+
+//Build it on the host with the same defs.h / main.h / config.h (USE_AD5932 = 1) as the firmware, no MCU_FAMILY:
+//	cc -O2 -I. -I<defs.h dir> tools/ad5932_demodbench.c ad5932_demod.c -lm -o ad5932_demodbench
+//
+//Usage:
+//	ad5932_demodbench <sample rate Hz> <samples per step> <steps> <seconds>
+//Builds the tagged capture blocks of a synthetic sweep once (a 1000 code sine per step, the step frequencies spread
+//over 2%..27% of the sample rate with whole cycles per step), then feeds them through AD5932_DemodBlock() over and
+//over for <seconds>, on one core. It prints the demodulated samples per second and the time per sample, and checks
+//every step result against the generated amplitude (1% limit). Pick <samples per step> as a divisor of the rate, so
+//the step frequencies are whole Hz.
+//The exit code is 0 only if the demodulator runs at least as fast as <sample rate Hz> and every result is right.
+//Add -DAD5932_DEMOD_FIXED=1 to the build line to check the fixed point kernel of the parts without FPU. The speed is
+//the one of the machine the bench runs on, not of the target.
+
+// --------------------------------------------------------------------------------------------------------------------
+// Includes
+// --------------------------------------------------------------------------------------------------------------------
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include "ad5932_demod.h"
+
+// --------------------------------------------------------------------------------------------------------------------
+// Defines
+// --------------------------------------------------------------------------------------------------------------------
+
+#define BENCH_AMPLITUDE		1000.0
+#define BENCH_OFFSET		2048
+#define BENCH_PI			3.14159265358979323846
+
+// --------------------------------------------------------------------------------------------------------------------
+// Variables
+// --------------------------------------------------------------------------------------------------------------------
+
+static unsigned long benchResults;
+static unsigned long benchBad;
+static double benchWorst;
+
+// --------------------------------------------------------------------------------------------------------------------
+// Functions
+// --------------------------------------------------------------------------------------------------------------------
+
+// ....................................................................................................................
+// @brief:      Demodulator output: checks the amplitude of every step
+// ....................................................................................................................
+static void Bench_Output(const AD5932DemodResult_t* result)
+{
+	double error = fabs(result->amplitude - BENCH_AMPLITUDE) / BENCH_AMPLITUDE;
+
+	benchResults++;
+	if (error > benchWorst)
+		benchWorst = error;
+	if (error > 0.01)
+		benchBad++;
+}
+
+// ....................................................................................................................
+// @brief:      Monotonic time in s
+// ....................................................................................................................
+static double Bench_Now(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (double)t.tv_sec + (double)t.tv_nsec * 1e-9;
+}
+
+// ....................................................................................................................
+// @brief:      Main
+// ....................................................................................................................
+int main(int argc, char* argv[])
+{
+	AD5932CaptureBlock_t* blocks;
+	unsigned long rate, stepSamples, steps, perStep, count, b, i, j, n, k;
+	unsigned long long samples = 0;
+	double seconds, start, elapsed, frequency, speed;
+
+	if (argc != 5)
+	{
+		fprintf(stderr, "usage: %s <sample rate Hz> <samples per step> <steps> <seconds>\n", argv[0]);
+		return 1;
+	}
+	rate = strtoul(argv[1], NULL, 0);
+	stepSamples = strtoul(argv[2], NULL, 0);
+	steps = strtoul(argv[3], NULL, 0);
+	seconds = atof(argv[4]);
+	if ((rate == 0) || (stepSamples == 0) || (steps == 0) || (steps > 65535))
+	{
+		fprintf(stderr, "the rate and the samples per step must not be 0, steps must be 1..65535\n");
+		return 1;
+	}
+
+	perStep = (stepSamples + AD5932_CAPTURE_BLOCK_SIZE - 1) / AD5932_CAPTURE_BLOCK_SIZE;
+	count = perStep * steps;
+	blocks = malloc(count * sizeof(AD5932CaptureBlock_t));
+	if (blocks == NULL)
+	{
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+
+	//the tagged blocks of one sweep, as AD5932_CaptureGet() would give them
+	for (k = 0, b = 0; k < steps; k++)
+	{
+		//whole cycles per step: the single bin DFT is exact then, any error is the demodulator's own
+		frequency = floor(stepSamples * (0.02 + 0.25 * k / steps) + 0.5) * rate / stepSamples;
+		for (i = 0; i < stepSamples; i += n, b++)
+		{
+			n = stepSamples - i;
+			if (n > AD5932_CAPTURE_BLOCK_SIZE)
+				n = AD5932_CAPTURE_BLOCK_SIZE;
+			blocks[b].step = (u16)k;
+			blocks[b].frequency = (u32)(frequency + 0.5);
+			blocks[b].sampleCount = (u32)n;
+			for (j = 0; j < n; j++)
+				blocks[b].samples[j] = (u16)(BENCH_OFFSET + BENCH_AMPLITUDE *
+										sin(2.0 * BENCH_PI * blocks[b].frequency * (double)(i + j) / rate + 0.3) + 0.5);
+		}
+	}
+
+	start = Bench_Now();
+	do
+	{
+		AD5932_DemodStart((u32)rate, BENCH_OFFSET, 0, Bench_Output);
+		for (b = 0; b < count; b++)
+			AD5932_DemodBlock(&blocks[b]);
+		AD5932_DemodFinish();
+		samples += (unsigned long long)stepSamples * steps;
+		elapsed = Bench_Now() - start;
+	} while (elapsed < seconds);
+
+	speed = samples / elapsed;
+	printf("%llu samples in %.3f s: %.2f MS/s, %.2f ns/sample, %.1fx the %lu S/s input\n", samples, elapsed,
+			speed / 1e6, elapsed * 1e9 / samples, speed / rate, rate);
+	printf("%lu step results, worst amplitude error %.4f%%, %lu over 1%%\n", benchResults, benchWorst * 100.0, benchBad);
+
+	free(blocks);
+	return ((speed < rate) || (benchBad != 0));
+}
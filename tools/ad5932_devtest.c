@@ -0,0 +1,320 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_devtest.c
+// @brief:      Host tool: unit tests of the AD5932 device contexts (ad5932_dev.c) over a simulated SSP transport
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+// --------------------------------------------------------------------------------------------------------------------
+// Notes
+// --------------------------------------------------------------------------------------------------------------------
+
+//Build it on the host with the firmware headers (defs.h, main.h, config.h with USE_AD5932 = 1, the LPC17xx driver
+//headers), the pins mocked and the PWM stepping left out, and link the driver itself:
+//	cc -I. -I<firmware include dirs> -DAD5932_PIN_MOCK -DAD5932_USE_PWM_CTRL=0 tools/ad5932_devtest.c ad5932.c ad5932_dev.c ad5932_plan.c -lm -o ad5932_devtest
+//
+//Usage:
+//	ad5932_devtest
+//The tool replaces the SSP driver and delay_us() as ad5932_vcdsim does. Every word is decoded into the register model
+//of the chip whose FSYNC is low at the time of the transfer (AD5932_DecodeCommand()), so the tests check what each
+//chip would hold, not what the driver thinks it sent. It prints one line per failed check and a summary, the exit code
+//is the number of failed checks.
+
+// --------------------------------------------------------------------------------------------------------------------
+// Includes
+// --------------------------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ad5932.h"
+#include "ad5932_dev.h"
+#include "ad5932_plan.h"
+
+// --------------------------------------------------------------------------------------------------------------------
+// Defines
+// --------------------------------------------------------------------------------------------------------------------
+
+#define TEST_CHIPS			2
+#define TEST_GLOBAL			TEST_CHIPS		//model of the driver's own chip (FSYNC pin)
+#define TEST_MCLK			50000000UL
+
+#define TEST_CHECK(cond)	Test_Check((cond), #cond, __LINE__)
+
+// --------------------------------------------------------------------------------------------------------------------
+// Variables
+// --------------------------------------------------------------------------------------------------------------------
+
+static LPC_SSP_TypeDef testSSP;
+static bool testBusy;						//SSP_GetTransferStatus() reports a busy port
+static bool testSelected[TEST_CHIPS];		//FSYNC level of the chips, true = low
+static AD5932Sweep_t chipSweep[TEST_CHIPS + 1];
+static u16 chipControl[TEST_CHIPS + 1];
+static u32 chipWords[TEST_CHIPS + 1];		//words received
+static u32 testChecks;
+static u32 testFailed;
+
+// --------------------------------------------------------------------------------------------------------------------
+// Functions
+// --------------------------------------------------------------------------------------------------------------------
+
+// ....................................................................................................................
+// @brief:      Counts a check and reports it if it failed
+// ....................................................................................................................
+static void Test_Check(bool ok, const char* text, int line)
+{
+	testChecks++;
+	if (ok)
+		return;
+	testFailed++;
+	printf("line %d: %s failed\n", line, text);
+}
+
+// ....................................................................................................................
+// @brief:      FSYNC control of the simulated chips
+// ....................................................................................................................
+static void Test_ChipSelect(u08 chip, bool state)
+{
+	if (chip < TEST_CHIPS)
+		testSelected[chip] = !state;
+}
+
+// ....................................................................................................................
+// @brief:      Clears the chip models
+// ....................................................................................................................
+static void Test_Reset(void)
+{
+	memset(chipSweep, 0, sizeof(chipSweep));
+	memset(chipControl, 0, sizeof(chipControl));
+	memset(chipWords, 0, sizeof(chipWords));
+	testBusy = false;
+}
+
+// ....................................................................................................................
+// @brief:      Replacements of the functions the driver calls
+// ....................................................................................................................
+void delay_us(u32 us)
+{
+	(void)us;
+}
+
+void SSP_ConfigStructInit(SSP_CFG_Type* config)
+{
+	memset(config, 0, sizeof(*config));
+}
+
+void SSP_Init(LPC_SSP_TypeDef* SSPx, SSP_CFG_Type* config)
+{
+	(void)SSPx;
+	(void)config;
+}
+
+void SSP_Cmd(LPC_SSP_TypeDef* SSPx, FunctionalState state)
+{
+	(void)SSPx;
+	(void)state;
+}
+
+s32 SSP_GetTransferStatus(LPC_SSP_TypeDef* SSPx)
+{
+	(void)SSPx;
+	return testBusy ? !SSP_STATUS_CLEAR : SSP_STATUS_CLEAR;
+}
+
+//same arguments as the driver call: port, rx buffer, tx buffer, callback, word count, transfer type
+s32 SSP_Transfer(LPC_SSP_TypeDef* SSPx, void* rxBuffer, void* txBuffer, void* callback, u32 length, u32 type)
+{
+	const u16* words = (const u16*)txBuffer;
+	u32 i, c;
+
+	(void)SSPx;
+	(void)rxBuffer;
+	(void)callback;
+	(void)type;
+	for (i = 0; i < length; i++)
+	{
+		for (c = 0; c < TEST_CHIPS; c++)
+		{
+			if (testSelected[c])
+			{
+				AD5932_DecodeCommand(words[i], &chipSweep[c], &chipControl[c]);
+				chipWords[c]++;
+			}
+		}
+		if (!(ad5932PinMock & AD5932_PIN_FSYNC))
+		{
+			AD5932_DecodeCommand(words[i], &chipSweep[TEST_GLOBAL], &chipControl[TEST_GLOBAL]);
+			chipWords[TEST_GLOBAL]++;
+		}
+	}
+	return length;
+}
+
+// ....................................................................................................................
+// @brief:      Init: MCLK 0 and a missing FSYNC control are rejected, a failed device can not be acquired
+// ....................................................................................................................
+static void Test_Init(void)
+{
+	AD5932Dev_t dev;
+	int owner;
+
+	TEST_CHECK(AD5932_DevInit(&dev, &testSSP, Test_ChipSelect, 0, 0) == AD5932_PARAM_ERROR);
+	TEST_CHECK(AD5932_DevAcquire(&dev, &owner) == AD5932_PARAM_ERROR);
+	TEST_CHECK(AD5932_DevInit(&dev, &testSSP, NULL, 0, TEST_MCLK) == AD5932_PARAM_ERROR);
+	TEST_CHECK(AD5932_DevInit(&dev, &testSSP, Test_ChipSelect, 0, TEST_MCLK) == 0);
+	TEST_CHECK(!testSelected[0]);
+	TEST_CHECK(AD5932_DevFrequencyToWord(&dev, 1000000) == AD5932_FrequencyToWord(1000000));
+	TEST_CHECK(AD5932_DevFrequencyToWord(&dev, TEST_MCLK) == 0x00FFFFFF);
+}
+
+// ....................................................................................................................
+// @brief:      Ownership: acquire, release, move, and a send of a non-owner does not reach the chip
+// ....................................................................................................................
+static void Test_Ownership(void)
+{
+	AD5932Dev_t dev;
+	int a, b;
+
+	Test_Reset();
+	AD5932_DevInit(&dev, &testSSP, Test_ChipSelect, 0, TEST_MCLK);
+	TEST_CHECK(AD5932_DevAcquire(&dev, NULL) == AD5932_PARAM_ERROR);
+	TEST_CHECK(AD5932_DevSend(&dev, &a, AD5932_NINCR | 10) == AD5932_PORT_BUSY);
+	TEST_CHECK(AD5932_DevAcquire(&dev, &a) == 0);
+	TEST_CHECK(AD5932_DevAcquire(&dev, &a) == 0);
+	TEST_CHECK(AD5932_DevAcquire(&dev, &b) == AD5932_PORT_BUSY);
+	TEST_CHECK(AD5932_DevSend(&dev, &b, AD5932_NINCR | 10) == AD5932_PORT_BUSY);
+	TEST_CHECK(chipWords[0] == 0);
+	TEST_CHECK(AD5932_DevRelease(&dev, &b) == AD5932_PORT_BUSY);
+
+	TEST_CHECK(AD5932_DevMove(&dev, &b, &a) == AD5932_PORT_BUSY);
+	TEST_CHECK(AD5932_DevMove(&dev, &a, &b) == 0);
+	TEST_CHECK(AD5932_DevSend(&dev, &a, AD5932_NINCR | 10) == AD5932_PORT_BUSY);
+	TEST_CHECK(AD5932_DevSend(&dev, &b, AD5932_NINCR | 10) == 0);
+	TEST_CHECK((chipWords[0] == 1) && (chipSweep[0].increment == 10) && (dev.sweep.increment == 10));
+	TEST_CHECK(AD5932_DevRelease(&dev, &b) == 0);
+	TEST_CHECK(AD5932_DevAcquire(&dev, &a) == 0);
+
+	//a busy port is reported and the device model is not updated
+	testBusy = true;
+	TEST_CHECK(AD5932_DevSend(&dev, &a, AD5932_NINCR | 20) == AD5932_PORT_BUSY);
+	TEST_CHECK((chipWords[0] == 1) && (dev.sweep.increment == 10));
+	testBusy = false;
+}
+
+// ....................................................................................................................
+// @brief:      Sweeps: the words the chip holds, the envelope checks, and independent devices on one bus
+// ....................................................................................................................
+static void Test_Sweep(void)
+{
+	AD5932Dev_t dev[TEST_CHIPS];
+	AD5932Params_t params;
+	AD5932Sweep_t global;
+	int a, b;
+
+	Test_Reset();
+	global = *AD5932_GetSweep();
+	AD5932_DevInit(&dev[0], &testSSP, Test_ChipSelect, 0, TEST_MCLK);
+	AD5932_DevInit(&dev[1], &testSSP, Test_ChipSelect, 1, TEST_MCLK / 2);
+	AD5932_DevAcquire(&dev[0], &a);
+	AD5932_DevAcquire(&dev[1], &b);
+
+	memset(&params, 0, sizeof(params));
+	params.startF = 1000000;
+	params.deltaF = 1000;
+	params.increment = 100;
+	params.intervall = 10;
+	params.incrementBase = WAVE_OUT_BASED;
+	params.sweepType = INCREMENTAL_SWEEP;
+	TEST_CHECK(AD5932_DevSweep(&dev[0], &a, &params, SINE_OUT, MSBOUT_EN, EXTERNAL_TRIGGER, SYNCSEL_END, SYNCOUT_EN) == 0);
+	TEST_CHECK(chipSweep[0].startWord == AD5932_DevFrequencyToWord(&dev[0], 1000000));
+	TEST_CHECK(chipSweep[0].deltaWord == AD5932_DevFrequencyToWord(&dev[0], 1000));
+	TEST_CHECK((chipSweep[0].increment == 100) && (chipSweep[0].intervall == 10));
+	TEST_CHECK((chipSweep[0].incrementBase == WAVE_OUT_BASED) && (chipSweep[0].sweepType == INCREMENTAL_SWEEP));
+	TEST_CHECK((chipSweep[0].startWord == dev[0].sweep.startWord) && (chipSweep[0].deltaWord == dev[0].sweep.deltaWord));
+	TEST_CHECK(chipControl[0] == dev[0].control);
+	TEST_CHECK(chipWords[1] == 0);
+
+	//the second chip has its own MCLK and runs down
+	params.sweepType = DECREMENTAL_SWEEP;
+	params.incrementBase = MCLK_INP_BASED;
+	TEST_CHECK(AD5932_DevSweep(&dev[1], &b, &params, TRIANGLE_OUT, MSBOUT_DISABLE, AUTOMATIC_TRIGGER, SYNCSEL_SUBSEQVENT, SYNCOUT_DISABLE) == 0);
+	TEST_CHECK(chipSweep[1].startWord == 2 * chipSweep[0].startWord || chipSweep[1].startWord == 2 * chipSweep[0].startWord + 1);
+	TEST_CHECK((chipSweep[1].sweepType == DECREMENTAL_SWEEP) && (chipSweep[1].incrementBase == MCLK_INP_BASED));
+	TEST_CHECK(chipSweep[0].sweepType == INCREMENTAL_SWEEP);
+	TEST_CHECK(chipControl[1] != chipControl[0]);
+
+	//the driver's own chip and its shadow are left alone
+	TEST_CHECK(chipWords[TEST_GLOBAL] == 0);
+	TEST_CHECK(memcmp(&global, AD5932_GetSweep(), sizeof(AD5932Sweep_t)) == 0);
+
+	//the owner of one device can not program the other
+	TEST_CHECK(AD5932_DevSweep(&dev[1], &a, &params, SINE_OUT, MSBOUT_EN, EXTERNAL_TRIGGER, SYNCSEL_END, SYNCOUT_EN) == AD5932_PORT_BUSY);
+
+	//envelope: NINCR, TINT, the end above Nyquist, and a delta * NINCR product that wraps 32 bits
+	params.sweepType = INCREMENTAL_SWEEP;
+	params.increment = 1;
+	TEST_CHECK(AD5932_DevSweep(&dev[0], &a, &params, SINE_OUT, MSBOUT_EN, EXTERNAL_TRIGGER, SYNCSEL_END, SYNCOUT_EN) == -6);
+	params.increment = 4096;
+	TEST_CHECK(AD5932_DevSweep(&dev[0], &a, &params, SINE_OUT, MSBOUT_EN, EXTERNAL_TRIGGER, SYNCSEL_END, SYNCOUT_EN) == -6);
+	params.increment = 100;
+	params.intervall = 2048;
+	TEST_CHECK(AD5932_DevSweep(&dev[0], &a, &params, SINE_OUT, MSBOUT_EN, EXTERNAL_TRIGGER, SYNCSEL_END, SYNCOUT_EN) == -6);
+	params.intervall = 10;
+	params.deltaF = TEST_MCLK / 100;
+	TEST_CHECK(AD5932_DevSweep(&dev[0], &a, &params, SINE_OUT, MSBOUT_EN, EXTERNAL_TRIGGER, SYNCSEL_END, SYNCOUT_EN) == -6);
+	params.startF = 0;
+	params.deltaF = 1000;
+	TEST_CHECK(AD5932_DevSweep(&dev[0], &a, &params, SINE_OUT, MSBOUT_EN, EXTERNAL_TRIGGER, SYNCSEL_END, SYNCOUT_EN) == -6);
+	params.startF = 1000000;
+	params.deltaF = 1000000;
+	params.sweepType = DECREMENTAL_SWEEP;
+	TEST_CHECK(AD5932_DevSweep(&dev[0], &a, &params, SINE_OUT, MSBOUT_EN, EXTERNAL_TRIGGER, SYNCSEL_END, SYNCOUT_EN) == -6);
+
+	//deltaWord 0x200000 * 2048 = 2^32: an u32 end word would be 0 and pass
+	params.sweepType = INCREMENTAL_SWEEP;
+	params.startF = 1000;
+	params.deltaF = TEST_MCLK / 8;
+	params.increment = 2048;
+	TEST_CHECK(AD5932_DevFrequencyToWord(&dev[0], params.deltaF) == 0x200000);
+	TEST_CHECK(AD5932_DevSweep(&dev[0], &a, &params, SINE_OUT, MSBOUT_EN, EXTERNAL_TRIGGER, SYNCSEL_END, SYNCOUT_EN) == -6);
+
+	//nothing of the rejected sweeps reached the chip
+	TEST_CHECK((chipSweep[0].startWord == AD5932_DevFrequencyToWord(&dev[0], 1000000)) && (chipSweep[0].increment == 100));
+}
+
+// ....................................................................................................................
+// @brief:      Single frequency: control word and start frequency
+// ....................................................................................................................
+static void Test_SingleFrequency(void)
+{
+	AD5932Dev_t dev;
+	int a;
+
+	Test_Reset();
+	AD5932_DevInit(&dev, &testSSP, Test_ChipSelect, 1, TEST_MCLK);
+	AD5932_DevAcquire(&dev, &a);
+	TEST_CHECK(AD5932_DevSingleFrequency(&dev, &a, 12345678, SINE_OUT, MSBOUT_EN) == 0);
+	TEST_CHECK(chipWords[1] == 3);
+	TEST_CHECK(chipSweep[1].startWord == AD5932_DevFrequencyToWord(&dev, 12345678));
+	TEST_CHECK(chipControl[1] == AD5932_PlanControlWord(SINE_OUT, MSBOUT_EN, EXTERNAL_TRIGGER, SYNCSEL_END, SYNCOUT_EN));
+	TEST_CHECK(chipWords[0] == 0);
+}
+
+// ....................................................................................................................
+// @brief:      Main
+// ....................................................................................................................
+int main(void)
+{
+	ad5932PinMock = AD5932_PIN_FSYNC;
+	AD5932_Init(TEST_MCLK);
+
+	Test_Init();
+	Test_Ownership();
+	Test_Sweep();
+	Test_SingleFrequency();
+
+	printf("%lu checks, %lu failed\n", (unsigned long)testChecks, (unsigned long)testFailed);
+	return (int)testFailed;
+}
@@ -0,0 +1,206 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_fitcheck.c
+// @brief:      Host tool: fits a logarithmic sweep with AD5932_PlanFit() and checks every segment step by step
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+// --------------------------------------------------------------------------------------------------------------------
+// Notes
+// --------------------------------------------------------------------------------------------------------------------
+
+//Build it on the host with the same defs.h / main.h / config.h (USE_AD5932 = 1) as the firmware, no MCU_FAMILY:
+//	cc -O2 -I. -I<defs.h dir> tools/ad5932_fitcheck.c ad5932_plan.c -lm -o ad5932_fitcheck
+//
+//Usage:
+//	ad5932_fitcheck <MCLK Hz> <from Hz> <to Hz> <duration ms> <frequency budget Hz> <time budget ns> <reprogram ns>
+//Fits f(t) = from * (to / from)^(t / duration) and prints the number of segments and the fitting time (best of a few
+//runs). Every segment is then checked on its own, from the register words alone, not from what AD5932_PlanFit()
+//reports about it: the output frequency of every step, at both ends of the step, has to be within the frequency
+//budget of the profile at that time, no step may be longer than the time budget, every segment has to start the
+//reprogramming time after the previous one ended, no segment but the last may be shorter than that, and the segments
+//have to cover the profile to the time budget. The reprogramming time is the bus time of the control register and
+//the plan words plus the CTRL pulse, 9 words at 5 MHz SCLK and the pulse are about 40 us. For example
+//	ad5932_fitcheck 50000000 1000 1000000 10000 500 40000 40000
+//is the 10 s, 1 kHz..1 MHz log sweep with a 500 Hz / 40 us budget. The exit code is 0 only if every check passed.
+
+// --------------------------------------------------------------------------------------------------------------------
+// Includes
+// --------------------------------------------------------------------------------------------------------------------
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include "ad5932_plan.h"
+
+// --------------------------------------------------------------------------------------------------------------------
+// Defines
+// --------------------------------------------------------------------------------------------------------------------
+
+#define FIT_MAX_SEGMENTS	60000
+#define FIT_RUNS			5
+
+// --------------------------------------------------------------------------------------------------------------------
+// Types
+// --------------------------------------------------------------------------------------------------------------------
+
+//logarithmic profile
+typedef struct
+{
+	double from;			//Hz
+	double ratio;			//to / from
+	double duration;		//ns
+} FitLog_t;
+
+// --------------------------------------------------------------------------------------------------------------------
+// Functions
+// --------------------------------------------------------------------------------------------------------------------
+
+//no AD5932 on the host: the planner is linked, sending a plan is not
+s32 AD5932_SendSPICommand(u16 commandWord) { (void)commandWord; return -1; }
+void AD5932_SaveShadow(void) { }
+
+// ....................................................................................................................
+// @brief:      Profile frequency at a time, rounded to Hz as AD5932_PlanFit() sees it
+// ....................................................................................................................
+static u32 Fit_Profile(void* context, u64 time)
+{
+	const FitLog_t* p = (const FitLog_t*)context;
+
+	return (u32)(p->from * pow(p->ratio, (double)time / p->duration) + 0.5);
+}
+
+// ....................................................................................................................
+// @brief:      Monotonic time in s
+// ....................................................................................................................
+static double Fit_Now(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (double)t.tv_sec + (double)t.tv_nsec * 1e-9;
+}
+
+// ....................................................................................................................
+// @brief:      Main
+// ....................................................................................................................
+int main(int argc, char* argv[])
+{
+	AD5932FitSegment_t* segments;
+	const AD5932Plan_t* plan;
+	FitLog_t profile;
+	unsigned long mclk, budget, timeBudget, reprogram, i, k, nincr, tint, startWord, deltaWord, bad = 0;
+	long double t, end = 0.0L, gap, period, frequency, error, worst = 0.0L;
+	double start, best = 0.0, elapsed;
+	bool decremental;
+	s32 count = 0;
+	int run, edge;
+
+	if (argc != 8)
+	{
+		fprintf(stderr, "usage: %s <MCLK Hz> <from Hz> <to Hz> <duration ms> <frequency budget Hz> <time budget ns> <reprogram ns>\n", argv[0]);
+		return 1;
+	}
+	mclk = strtoul(argv[1], NULL, 0);
+	profile.from = atof(argv[2]);
+	profile.ratio = atof(argv[3]) / profile.from;
+	profile.duration = atof(argv[4]) * 1e6;
+	budget = strtoul(argv[5], NULL, 0);
+	timeBudget = strtoul(argv[6], NULL, 0);
+	reprogram = strtoul(argv[7], NULL, 0);
+	if ((mclk == 0) || (profile.from <= 0.0) || (profile.ratio <= 0.0) || (profile.duration <= 0.0))
+	{
+		fprintf(stderr, "MCLK, the frequencies and the duration must be positive\n");
+		return 1;
+	}
+
+	segments = malloc(FIT_MAX_SEGMENTS * sizeof(AD5932FitSegment_t));
+	if (segments == NULL)
+	{
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	for (run = 0; run < FIT_RUNS; run++)
+	{
+		start = Fit_Now();
+		count = AD5932_PlanFit(Fit_Profile, &profile, (u64)profile.duration, (u32)budget, (u32)timeBudget, (u32)reprogram, (u32)mclk,
+								segments, FIT_MAX_SEGMENTS);
+		elapsed = Fit_Now() - start;
+		if ((run == 0) || (elapsed < best))
+			best = elapsed;
+	}
+	if ((count == AD5932_PARAM_ERROR) || (count > FIT_MAX_SEGMENTS))
+	{
+		printf("no fit within the budgets (%ld)\n", (long)count);
+		free(segments);
+		return 1;
+	}
+
+	period = 1e9L / mclk;
+	gap = floorl((long double)reprogram * mclk / 1e9L + 0.5L) * period;
+	for (i = 0; i < (unsigned long)count; i++)
+	{
+		plan = &segments[i].plan;
+		startWord = (plan->words[AD5932_PLAN_FSTART_LO] & 0x0FFF) | ((unsigned long)(plan->words[AD5932_PLAN_FSTART_HI] & 0x0FFF) << 12);
+		deltaWord = (plan->words[AD5932_PLAN_DFREQ_LO] & 0x0FFF) | ((unsigned long)(plan->words[AD5932_PLAN_DFREQ_HI] & 0x07FF) << 12);
+		decremental = (plan->words[AD5932_PLAN_DFREQ_HI] & 0x0800) != 0;
+		tint = plan->words[AD5932_PLAN_TINT] & 0x07FF;
+		nincr = plan->words[AD5932_PLAN_NINCR] & 0x0FFF;
+
+		//this segment starts the reprogramming time after the previous one ended (the reported times are truncated to ns)
+		if (i != 0)
+			end += gap;
+		if (fabsl((long double)segments[i].start - end) > 1.0L)
+		{
+			printf("segment %lu starts at %llu ns, the previous one ended at %.0Lf ns\n", i, (unsigned long long)segments[i].start, end);
+			bad++;
+		}
+		if ((nincr < 2) || (tint < 2) || (tint * period > timeBudget))
+		{
+			printf("segment %lu: NINCR %lu, TINT %lu out of range or longer than the time budget\n", i, nincr, tint);
+			bad++;
+		}
+		if ((i + 1 < (unsigned long)count) && ((gap > timeBudget) || ((long double)tint * (nincr + 1) * period < gap)))
+		{
+			printf("segment %lu: %.0Lf ns, the %.0Lf ns reprogramming gap after it is longer than the segment or the time budget\n", i,
+					(long double)tint * (nincr + 1) * period, gap);
+			bad++;
+		}
+
+		//every step, at both ends, against the profile
+		for (k = 0; k <= nincr; k++)
+		{
+			frequency = (decremental ? (long double)startWord - (long double)k * deltaWord : (long double)startWord + (long double)k * deltaWord) *
+						mclk / AD5932_ACCU_RESOLUTION;
+			for (edge = 0; edge < 2; edge++)
+			{
+				t = end + ((long double)k * tint + (edge ? tint - 1 : 0)) * period;
+				error = fabsl(frequency - (long double)profile.from * powl((long double)profile.ratio, t / (long double)profile.duration));
+				if (error > worst)
+					worst = error;
+				if (error > budget)
+				{
+					if (bad < 10)
+						printf("segment %lu step %lu: %.1Lf Hz off the profile at %.0Lf ns\n", i, k, error, t);
+					bad++;
+				}
+			}
+		}
+		end += (long double)tint * (nincr + 1) * period;
+	}
+	if (profile.duration - end > timeBudget)
+	{
+		printf("the segments end at %.0Lf ns, %.0Lf ns before the profile\n", end, profile.duration - end);
+		bad++;
+	}
+
+	printf("%ld segments in %.3f ms, worst step error %.1Lf Hz of %lu Hz, %lu failed checks\n", (long)count, best * 1e3,
+			worst, budget, bad);
+	free(segments);
+	return (bad != 0);
+}
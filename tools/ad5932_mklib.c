@@ -0,0 +1,247 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_mklib.c
+// @brief:      Host tool: builds / dumps precompiled AD5932 sweep libraries (see ad5932_lib.h)
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+// --------------------------------------------------------------------------------------------------------------------
+// Notes
+// --------------------------------------------------------------------------------------------------------------------
+
+//Build it on the host together with ad5932_plan.c and ad5932_lib.c, with the same defs.h / main.h / config.h
+//(USE_AD5932 = 1) as the firmware, and no MCU_FAMILY defined:
+//	cc -I. -I<defs.h dir> tools/ad5932_mklib.c ad5932_plan.c ad5932_lib.c -o ad5932_mklib
+//
+//Usage:
+//	ad5932_mklib <MCLK Hz> <plan.txt> <library.bin>		builds the library
+//	ad5932_mklib -d <library.bin>						dumps a library (mmap-ed, through the firmware accessors)
+//
+//Plan description, one sweep per line, '#' starts a comment:
+//	<start Hz> <stop Hz> <duration us> [sine|triangle] [msbout] [external] [syncstep] [nosync]
+//Defaults: sine, MSBOUT disabled, automatic trigger, SYNCOUT at the end of scan.
+//The words are calculated for the given MCLK as it is, no ppb or temperature correction is applied. Give the
+//calibrated MCLK (nominal * (1 + ppb / 1e9)) to build a library for a corrected clock.
+
+// --------------------------------------------------------------------------------------------------------------------
+// Includes
+// --------------------------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "ad5932_lib.h"
+
+// --------------------------------------------------------------------------------------------------------------------
+// Defines
+// --------------------------------------------------------------------------------------------------------------------
+
+#define MKLIB_MAX_SWEEPS	4096
+
+// --------------------------------------------------------------------------------------------------------------------
+// Functions
+// --------------------------------------------------------------------------------------------------------------------
+
+//no AD5932 on the host: the library accessors are linked, running a sweep is not
+s32 AD5932_SendSPICommand(u16 commandWord) { (void)commandWord; return -1; }
+void AD5932_SetCTRLPin(bool state) { (void)state; }
+void AD5932_TriggerCTRLPin(void) { }
+void AD5932_SaveShadow(void) { }
+
+// ....................................................................................................................
+// @brief:      Parses one plan line into a library entry
+// @param[in]:  Line
+// @param[in]:  MCLK in Hz
+// @param[out]: Entry
+// @return:     1 if an entry was made, 0 for empty / comment lines, negative on error.
+// ....................................................................................................................
+static int MkLib_ParseLine(char* line, u32 mclk, AD5932LibSweep_t* sweep)
+{
+	RegBits_t wave = SINE_OUT, msbout = MSBOUT_DISABLE, trigger = AUTOMATIC_TRIGGER, syncsel = SYNCSEL_END, syncout = SYNCOUT_EN;
+	unsigned long startF, stopF;
+	unsigned long long durationUs;
+	AD5932Plan_t plan;
+	char* token;
+	char* comment;
+
+	comment = strchr(line, '#');
+	if (comment != NULL)
+		*comment = '\0';
+
+	token = strtok(line, " \t\r\n");
+	if (token == NULL)
+		return 0;
+	startF = strtoul(token, NULL, 0);
+	token = strtok(NULL, " \t\r\n");
+	if (token == NULL)
+		return -1;
+	stopF = strtoul(token, NULL, 0);
+	token = strtok(NULL, " \t\r\n");
+	if (token == NULL)
+		return -1;
+	durationUs = strtoull(token, NULL, 0);
+
+	while ((token = strtok(NULL, " \t\r\n")) != NULL)
+	{
+		if (!strcmp(token, "sine"))
+			wave = SINE_OUT;
+		else if (!strcmp(token, "triangle"))
+			wave = TRIANGLE_OUT;
+		else if (!strcmp(token, "msbout"))
+			msbout = MSBOUT_EN;
+		else if (!strcmp(token, "external"))
+			trigger = EXTERNAL_TRIGGER;
+		else if (!strcmp(token, "syncstep"))
+			syncsel = SYNCSEL_SUBSEQVENT;
+		else if (!strcmp(token, "nosync"))
+			syncout = SYNCOUT_DISABLE;
+		else
+			return -2;
+	}
+
+	if (AD5932_PlanSweep((u32)startF, (u32)stopF, (u64)durationUs * 1000, mclk, &plan) != 0)
+		return -3;
+
+	memset(sweep, 0, sizeof(*sweep));
+	sweep->control = AD5932_PlanControlWord(wave, msbout, trigger, syncsel, syncout);
+	memcpy(sweep->words, plan.words, sizeof(sweep->words));
+	//(NINCR + 1) * TINT MCLK periods, the planned duration instead of the requested one
+	sweep->duration = ((u64)(plan.words[AD5932_PLAN_TINT] & 0x07FF) * ((plan.words[AD5932_PLAN_NINCR] & 0x0FFF) + 1) * 1000000000 + mclk / 2) / mclk;
+	return 1;
+}
+
+// ....................................................................................................................
+// @brief:      Builds a library file from a plan description
+// @param[in]:  MCLK in Hz
+// @param[in]:  Plan description path
+// @param[in]:  Library path
+// @return:     Process exit code
+// ....................................................................................................................
+static int MkLib_Build(u32 mclk, const char* planPath, const char* libPath)
+{
+	static AD5932LibSweep_t sweeps[MKLIB_MAX_SWEEPS];
+	AD5932LibHeader_t header;
+	char line[256];
+	FILE* in;
+	FILE* out;
+	int lineNo = 0, ret;
+	u16 count = 0;
+
+	in = fopen(planPath, "r");
+	if (in == NULL)
+	{
+		perror(planPath);
+		return 1;
+	}
+
+	while (fgets(line, sizeof(line), in) != NULL)
+	{
+		lineNo++;
+		if (count == MKLIB_MAX_SWEEPS)
+		{
+			fprintf(stderr, "%s: too many sweeps\n", planPath);
+			fclose(in);
+			return 1;
+		}
+		ret = MkLib_ParseLine(line, mclk, &sweeps[count]);
+		if (ret < 0)
+		{
+			fprintf(stderr, "%s:%d: %s\n", planPath, lineNo, (ret == -3) ? "no AD5932 plan for this sweep" : "syntax error");
+			fclose(in);
+			return 1;
+		}
+		count += ret;
+	}
+	fclose(in);
+
+	header.magic = AD5932_LIB_MAGIC;
+	header.version = AD5932_LIB_VERSION;
+	header.count = count;
+	header.mclk = mclk;
+	header.checksum = AD5932_LibChecksum(sweeps, count * sizeof(AD5932LibSweep_t));
+
+	out = fopen(libPath, "wb");
+	if (out == NULL)
+	{
+		perror(libPath);
+		return 1;
+	}
+	if ((fwrite(&header, sizeof(header), 1, out) != 1) || (fwrite(sweeps, sizeof(AD5932LibSweep_t), count, out) != count))
+	{
+		perror(libPath);
+		fclose(out);
+		return 1;
+	}
+	fclose(out);
+
+	printf("%s: %u sweeps, %u bytes\n", libPath, count, (unsigned)(sizeof(header) + count * sizeof(AD5932LibSweep_t)));
+	return 0;
+}
+
+// ....................................................................................................................
+// @brief:      Dumps a library file, mapped into memory and read in place like on the target
+// @param[in]:  Library path
+// @return:     Process exit code
+// ....................................................................................................................
+static int MkLib_Dump(const char* libPath)
+{
+	const AD5932LibHeader_t* header;
+	const AD5932LibSweep_t* sweep;
+	struct stat st;
+	void* lib;
+	int fd;
+	u16 i, w;
+
+	fd = open(libPath, O_RDONLY);
+	if ((fd < 0) || (fstat(fd, &st) != 0))
+	{
+		perror(libPath);
+		return 1;
+	}
+	lib = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (lib == MAP_FAILED)
+	{
+		perror(libPath);
+		return 1;
+	}
+
+	if (AD5932_LibCheck(lib, (u32)st.st_size, 0) != 0)
+	{
+		fprintf(stderr, "%s: not a valid AD5932 library\n", libPath);
+		munmap(lib, st.st_size);
+		return 1;
+	}
+
+	header = (const AD5932LibHeader_t*)lib;
+	printf("version %u, MCLK %lu Hz, %u sweeps\n", header->version, (unsigned long)header->mclk, header->count);
+	for (i = 0; i < header->count; i++)
+	{
+		sweep = AD5932_LibGet(lib, i);
+		printf("%4u: %04X", i, sweep->control);
+		for (w = 0; w < AD5932_PLAN_WORDS; w++)
+			printf(" %04X", sweep->words[w]);
+		printf("  %llu ns\n", (unsigned long long)sweep->duration);
+	}
+
+	munmap(lib, st.st_size);
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	if ((argc == 3) && !strcmp(argv[1], "-d"))
+		return MkLib_Dump(argv[2]);
+	if (argc == 4)
+		return MkLib_Build((u32)strtoul(argv[1], NULL, 0), argv[2], argv[3]);
+
+	fprintf(stderr, "usage: %s <MCLK Hz> <plan.txt> <library.bin>\n       %s -d <library.bin>\n", argv[0], argv[0]);
+	return 2;
+}
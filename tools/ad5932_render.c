@@ -0,0 +1,375 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_render.c
+// @brief:      Host tool: renders the DAC output of an AD5932 sweep on more threads
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+// --------------------------------------------------------------------------------------------------------------------
+// Notes
+// --------------------------------------------------------------------------------------------------------------------
+
+//Build it on the host with the same defs.h / main.h / config.h (USE_AD5932 = 1) as the firmware, no MCU_FAMILY:
+//	cc -O2 -I. -I<defs.h dir> tools/ad5932_render.c ad5932_sim.c -lm -lpthread -o ad5932_render
+//
+//Usage:
+//	ad5932_render <MCLK Hz> <start Hz> <delta Hz> <increments> <interval> <mclk|wave> <sine|triangle> <decimation> <threads> <out.raw> [dec] [check]
+//Renders a sweep (incremental, or decremental with "dec") from the CTRL trigger to its end, one 16 bit DAC code
+//(native byte order) per <decimation> MCLK periods. The samples are cut into rounds of <threads> chunks. The worker
+//threads are started once and wait for the rounds: every worker renders its chunk with AD5932_SimRender() from the
+//jump-ahead phase of the chunk start, then the round is written out in order.
+//With "check" the samples are compared with a plain reference that shares no code with the model: a 24 bit
+//accumulator that adds the word of the running step every MCLK cycle (acc += word) from the trigger, and counts TINT
+//cycles or TINT overflows to step, so the output is proven to be the same as a cycle by cycle run for any thread count.
+
+// --------------------------------------------------------------------------------------------------------------------
+// Includes
+// --------------------------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "ad5932_sim.h"
+
+// --------------------------------------------------------------------------------------------------------------------
+// Defines
+// --------------------------------------------------------------------------------------------------------------------
+
+#define RENDER_CHUNK		(1 << 20)		//samples per thread and round
+#define RENDER_THREADS		64
+
+// --------------------------------------------------------------------------------------------------------------------
+// Types
+// --------------------------------------------------------------------------------------------------------------------
+
+typedef struct
+{
+	u64 first;				//first sample of the chunk
+	u32 count;				//samples asked
+	u32 done;				//samples rendered
+	u16* out;
+} RenderChunk_t;
+
+//worker threads, chunk i of every round is rendered by worker i
+typedef struct
+{
+	pthread_t thread[RENDER_THREADS];
+	pthread_mutex_t lock;
+	pthread_cond_t start;	//a new round or the end
+	pthread_cond_t done;	//a worker finished its chunk
+	u32 workers;			//started, chunks from this one on are rendered by the main thread
+	u32 round;				//round counter, the workers wait for it to change
+	u32 busy;				//workers still rendering the round
+	bool stop;
+} RenderPool_t;
+
+//cycle by cycle reference of the chip
+typedef struct
+{
+	u64 cycle;				//MCLK cycles from the trigger
+	u32 acc;				//accumulator, 24 bit
+	u32 step;				//0..NINCR, NINCR + 1 after the end
+	u32 word;				//tuning word of the step
+	u32 count;				//cycles (MCLK based) or overflows (output based) in the step
+} RenderRef_t;
+
+// --------------------------------------------------------------------------------------------------------------------
+// Variables
+// --------------------------------------------------------------------------------------------------------------------
+
+static AD5932Sweep_t renderSweep;
+static RegBits_t renderWave;
+static u32 renderDecimation;
+static RenderChunk_t renderChunk[RENDER_THREADS];
+static RenderPool_t renderPool;
+
+// --------------------------------------------------------------------------------------------------------------------
+// Functions
+// --------------------------------------------------------------------------------------------------------------------
+
+// ....................................................................................................................
+// @brief:      Renders one chunk
+// ....................................................................................................................
+static void Render_Chunk(RenderChunk_t* chunk)
+{
+	chunk->done = AD5932_SimRender(&renderSweep, renderWave, chunk->first, chunk->count, renderDecimation, chunk->out);
+}
+
+// ....................................................................................................................
+// @brief:      Worker thread: renders its chunk of every round until the pool is stopped
+// @param[in]:  Worker index
+// ....................................................................................................................
+static void* Render_Worker(void* arg)
+{
+	u32 index = (u32)(size_t)arg;
+	u32 round = 0;
+
+	pthread_mutex_lock(&renderPool.lock);
+	while (true)
+	{
+		while (!renderPool.stop && (renderPool.round == round))
+			pthread_cond_wait(&renderPool.start, &renderPool.lock);
+		if (renderPool.stop)
+			break;
+		round = renderPool.round;
+		pthread_mutex_unlock(&renderPool.lock);
+
+		Render_Chunk(&renderChunk[index]);
+
+		pthread_mutex_lock(&renderPool.lock);
+		if (--renderPool.busy == 0)
+			pthread_cond_signal(&renderPool.done);
+	}
+	pthread_mutex_unlock(&renderPool.lock);
+	return NULL;
+}
+
+// ....................................................................................................................
+// @brief:      Starts the worker threads. The main thread renders the chunks of the workers that could not start.
+// @param[in]:  Chunks per round
+// ....................................................................................................................
+static void Render_PoolStart(u32 threads)
+{
+	pthread_mutex_init(&renderPool.lock, NULL);
+	pthread_cond_init(&renderPool.start, NULL);
+	pthread_cond_init(&renderPool.done, NULL);
+	for (renderPool.workers = 0; renderPool.workers < threads; renderPool.workers++)
+		if (pthread_create(&renderPool.thread[renderPool.workers], NULL, Render_Worker, (void*)(size_t)renderPool.workers) != 0)
+			break;
+}
+
+// ....................................................................................................................
+// @brief:      Renders one round of chunks on the workers and waits for all of them
+// @param[in]:  Chunks of the round
+// ....................................................................................................................
+static void Render_PoolRound(u32 threads)
+{
+	u32 i;
+
+	pthread_mutex_lock(&renderPool.lock);
+	renderPool.busy = renderPool.workers;
+	renderPool.round++;
+	pthread_cond_broadcast(&renderPool.start);
+	pthread_mutex_unlock(&renderPool.lock);
+
+	for (i = renderPool.workers; i < threads; i++)
+		Render_Chunk(&renderChunk[i]);
+
+	pthread_mutex_lock(&renderPool.lock);
+	while (renderPool.busy != 0)
+		pthread_cond_wait(&renderPool.done, &renderPool.lock);
+	pthread_mutex_unlock(&renderPool.lock);
+}
+
+// ....................................................................................................................
+// @brief:      Stops and joins the worker threads
+// ....................................................................................................................
+static void Render_PoolStop(void)
+{
+	u32 i;
+
+	pthread_mutex_lock(&renderPool.lock);
+	renderPool.stop = true;
+	pthread_cond_broadcast(&renderPool.start);
+	pthread_mutex_unlock(&renderPool.lock);
+	for (i = 0; i < renderPool.workers; i++)
+		pthread_join(renderPool.thread[i], NULL);
+}
+
+// ....................................................................................................................
+// @brief:      Tuning word of a step of the reference
+// ....................................................................................................................
+static u32 Render_RefWord(u32 step)
+{
+	if (renderSweep.sweepType == DECREMENTAL_SWEEP)
+		return (u32)((renderSweep.startWord - (u64)step * renderSweep.deltaWord) & 0x00FFFFFF);
+	return (u32)((renderSweep.startWord + (u64)step * renderSweep.deltaWord) & 0x00FFFFFF);
+}
+
+// ....................................................................................................................
+// @brief:      Runs the reference cycle by cycle: acc += word, and the next step after TINT cycles / overflows
+// @param[in]:  Reference, moved on
+// @param[in]:  Cycle to stop at
+// @return:     false if the sweep ends before the cycle
+// ....................................................................................................................
+static bool Render_RefRun(RenderRef_t* ref, u64 cycle)
+{
+	while (ref->cycle < cycle)
+	{
+		if (ref->step > renderSweep.increment)
+			return false;
+		if ((renderSweep.incrementBase != WAVE_OUT_BASED) || (ref->acc + ref->word >= AD5932_ACCU_RESOLUTION))
+			ref->count++;
+		ref->acc = (ref->acc + ref->word) & 0x00FFFFFF;
+		ref->cycle++;
+		if (ref->count == renderSweep.intervall)
+		{
+			ref->step++;
+			ref->word = Render_RefWord(ref->step);
+			ref->count = 0;
+		}
+	}
+	return (ref->step <= renderSweep.increment);
+}
+
+// ....................................................................................................................
+// @brief:      Compares rendered samples with the reference
+// @param[in]:  Reference, moved on
+// @param[in]:  First sample, count, rendered samples
+// @param[in]:  The render ended after these samples
+// @return:     false at the first difference
+// ....................................................................................................................
+static bool Render_Check(RenderRef_t* ref, u64 first, u32 count, const u16* samples, bool end)
+{
+	u64 decimation = renderDecimation ? renderDecimation : 1;
+	u32 i;
+
+	for (i = 0; i < count; i++)
+	{
+		if (!Render_RefRun(ref, (first + i) * decimation) || (AD5932_SimDac(ref->acc, renderWave) != samples[i]))
+		{
+			fprintf(stderr, "chunked render differs from the cycle by cycle reference at sample %llu\n", (unsigned long long)(first + i));
+			return false;
+		}
+	}
+	if (end && Render_RefRun(ref, (first + count) * decimation))
+	{
+		fprintf(stderr, "chunked render ended at sample %llu, before the reference\n", (unsigned long long)(first + count));
+		return false;
+	}
+	return true;
+}
+
+// ....................................................................................................................
+// @brief:      Converts a frequency to a tuning word
+// ....................................................................................................................
+static u32 Render_Word(u32 frequency, u32 mclk)
+{
+	return (u32)(((((u64)frequency << 24) + mclk / 2) / mclk) & 0x00FFFFFF);
+}
+
+// ....................................................................................................................
+// @brief:      Main
+// ....................................................................................................................
+int main(int argc, char* argv[])
+{
+	RenderRef_t ref;
+	u16* buffer;
+	FILE* out;
+	u64 first = 0, written = 0, word;
+	u32 threads, total, i;
+	bool check = false, end = false;
+	int arg;
+
+	if ((argc < 11) || (argc > 13))
+	{
+		fprintf(stderr, "usage: %s <MCLK Hz> <start Hz> <delta Hz> <increments> <interval> <mclk|wave> <sine|triangle> "
+				"<decimation> <threads> <out.raw> [dec] [check]\n", argv[0]);
+		return 1;
+	}
+	renderSweep.mclk = strtoul(argv[1], NULL, 0);
+	if (renderSweep.mclk == 0)
+	{
+		fprintf(stderr, "MCLK must not be 0\n");
+		return 1;
+	}
+	renderSweep.startWord = Render_Word(strtoul(argv[2], NULL, 0), renderSweep.mclk);
+	renderSweep.deltaWord = Render_Word(strtoul(argv[3], NULL, 0), renderSweep.mclk);
+	renderSweep.increment = (u16)strtoul(argv[4], NULL, 0);
+	renderSweep.intervall = (u16)strtoul(argv[5], NULL, 0);
+	renderSweep.incrementBase = (strcmp(argv[6], "wave") == 0) ? WAVE_OUT_BASED : MCLK_INP_BASED;
+	renderSweep.sweepType = INCREMENTAL_SWEEP;
+	renderWave = (strcmp(argv[7], "triangle") == 0) ? TRIANGLE_OUT : SINE_OUT;
+	renderDecimation = strtoul(argv[8], NULL, 0);
+	threads = strtoul(argv[9], NULL, 0);
+	for (arg = 11; arg < argc; arg++)
+	{
+		if (strcmp(argv[arg], "dec") == 0)
+			renderSweep.sweepType = DECREMENTAL_SWEEP;
+		else if (strcmp(argv[arg], "check") == 0)
+			check = true;
+		else
+		{
+			fprintf(stderr, "unknown option %s\n", argv[arg]);
+			return 1;
+		}
+	}
+	if (threads == 0)
+		threads = 1;
+	if (threads > RENDER_THREADS)
+		threads = RENDER_THREADS;
+
+	//a zero word would never end an output based step
+	word = (u64)renderSweep.increment * renderSweep.deltaWord;
+	if ((renderSweep.increment < 2) || (renderSweep.increment > 4095) || (renderSweep.intervall < 2) || (renderSweep.intervall > 2047) ||
+		(renderSweep.startWord == 0) || ((renderSweep.sweepType == DECREMENTAL_SWEEP) ? (word >= renderSweep.startWord) :
+		(renderSweep.startWord + word >= AD5932_ACCU_RESOLUTION / 2)))
+	{
+		fprintf(stderr, "increments 2..4095, interval 2..2047, the sweep must stay in 0 < f < MCLK / 2\n");
+		return 1;
+	}
+
+	buffer = malloc((size_t)threads * RENDER_CHUNK * sizeof(u16));
+	if (buffer == NULL)
+	{
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	out = fopen(argv[10], "wb");
+	if (out == NULL)
+	{
+		perror(argv[10]);
+		return 1;
+	}
+
+	AD5932_SimInit();		//the sine ROM, before the threads share it
+	memset(&ref, 0, sizeof(ref));
+	ref.word = Render_RefWord(0);
+	for (i = 0; i < threads; i++)
+	{
+		renderChunk[i].count = RENDER_CHUNK;
+		renderChunk[i].out = buffer + (size_t)i * RENDER_CHUNK;
+	}
+	Render_PoolStart(threads);
+	while (!end)
+	{
+		for (i = 0; i < threads; i++)
+			renderChunk[i].first = first + (u64)i * RENDER_CHUNK;
+		Render_PoolRound(threads);
+		total = 0;
+		for (i = 0; i < threads; i++)
+		{
+			if (!end)
+				total += renderChunk[i].done;
+			if (renderChunk[i].done < renderChunk[i].count)
+				end = true;
+		}
+
+		if (check && !Render_Check(&ref, first, total, buffer, end))
+		{
+			Render_PoolStop();
+			fclose(out);
+			return 2;
+		}
+		if (fwrite(buffer, sizeof(u16), total, out) != total)
+		{
+			fprintf(stderr, "write error\n");
+			Render_PoolStop();
+			fclose(out);
+			return 1;
+		}
+		first += total;
+		written += total;
+	}
+	Render_PoolStop();
+
+	fprintf(stderr, "%llu samples, %.6f s of output\n", (unsigned long long)written,
+			(double)written * (renderDecimation ? renderDecimation : 1) / renderSweep.mclk);
+	fclose(out);
+	free(buffer);
+	return 0;
+}
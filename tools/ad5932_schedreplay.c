@@ -0,0 +1,386 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_schedreplay.c
+// @brief:      Host tool: replays recorded sweep job traces through the AD5932 scheduler on a virtual clock
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+// --------------------------------------------------------------------------------------------------------------------
+// Notes
+// --------------------------------------------------------------------------------------------------------------------
+
+//Build it on the host with the firmware headers (defs.h, main.h, config.h with USE_AD5932 = 1, the LPC17xx driver
+//headers), the pins mocked and the PWM stepping left out, and link the driver itself:
+//	cc -O2 -I. -I<firmware include dirs> -DAD5932_PIN_MOCK -DAD5932_USE_PWM_CTRL=0 tools/ad5932_schedreplay.c ad5932.c ad5932_dev.c ad5932_plan.c ad5932_sched.c -o ad5932_schedreplay
+//
+//Usage:
+//	ad5932_schedreplay <MCLK Hz> <SCLK Hz> <tolerance us> <task period us> <trace.txt>
+//Job trace, one job per line in submit order, '#' starts a comment:
+//	<submit us> <deadline us> <channel 0..15> <start Hz> <delta Hz> <increments> <interval> [wave] [dec]
+//Defaults: MCLK based interval, incremental sweep. The job id is the line number.
+//
+//The unmodified scheduler runs on a virtual clock: it advances by <task period us> per AD5932_SchedTask() call (the
+//main loop period of the target) and by the bus time of every command word on the simulated SSP, 16 bits at SCLK
+//plus AD5932_SCHED_WORD_OVERHEAD. Idle time without queued jobs is skipped. So the replay runs as fast as the host
+//can, the summary gives the acceleration against real time. Jobs are submitted when the clock reaches their submit
+//time. Every word is decoded into the register model of the chip whose FSYNC is low, and at every trigger the chip
+//has to hold the sweep of the triggered job. After every AD5932_SchedTask() call, a channel with a programmed job has
+//to be owned by the scheduler, so nobody else can reprogram it before its trigger.
+//Misses are printed as they are reported (id, channel, lateness in us, programming result), then a summary. The exit
+//code is 0 only if every job was triggered or reported failed, every triggered chip held its own sweep, and no
+//programmed channel was left free.
+
+// --------------------------------------------------------------------------------------------------------------------
+// Includes
+// --------------------------------------------------------------------------------------------------------------------
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ad5932.h"
+#include "ad5932_dev.h"
+#include "ad5932_sched.h"
+
+// --------------------------------------------------------------------------------------------------------------------
+// Defines
+// --------------------------------------------------------------------------------------------------------------------
+
+#define REPLAY_CHANNELS		16
+#define REPLAY_MAX_JOBS		100000
+
+// --------------------------------------------------------------------------------------------------------------------
+// Types
+// --------------------------------------------------------------------------------------------------------------------
+
+//one line of the trace
+typedef struct
+{
+	u64 submit;					//us
+	AD5932Job_t job;
+} ReplayJob_t;
+
+// --------------------------------------------------------------------------------------------------------------------
+// Variables
+// --------------------------------------------------------------------------------------------------------------------
+
+static LPC_SSP_TypeDef replaySSP;
+static u64 replayNs;						//virtual time
+static u64 replayWordNs;					//bus time of one command word
+static AD5932Dev_t replayDev[REPLAY_CHANNELS];
+static AD5932Sched_t replaySched;
+static ReplayJob_t* replayJobs;
+
+//chip models
+static bool chipSelected[REPLAY_CHANNELS];	//FSYNC low
+static AD5932Sweep_t chipSweep[REPLAY_CHANNELS];
+static u16 chipControl[REPLAY_CHANNELS];
+
+//results
+static u32 replayFailed;					//programming failed
+static u32 replayMismatch;					//triggered chip did not hold the sweep of the job
+static u32 replayUnowned;					//checks with a programmed channel not owned by the scheduler
+
+// --------------------------------------------------------------------------------------------------------------------
+// Functions
+// --------------------------------------------------------------------------------------------------------------------
+
+// ....................................................................................................................
+// @brief:      Virtual time base of the scheduler, in us
+// ....................................................................................................................
+static u32 Replay_TimeBase(void)
+{
+	return (u32)(replayNs / 1000);
+}
+
+// ....................................................................................................................
+// @brief:      FSYNC control of the simulated chips
+// ....................................................................................................................
+static void Replay_ChipSelect(u08 chip, bool state)
+{
+	if (chip < REPLAY_CHANNELS)
+		chipSelected[chip] = !state;
+}
+
+// ....................................................................................................................
+// @brief:      CTRL trigger of a channel: the chip has to hold the sweep of its programmed job
+// ....................................................................................................................
+static void Replay_Trigger(AD5932Dev_t* dev)
+{
+	const AD5932Job_t* job = NULL;
+	const AD5932Sweep_t* chip = &chipSweep[dev->chip];
+	u08 i;
+
+	//the scheduler programs one job per channel at a time
+	for (i = 0; i < replaySched.count; i++)
+	{
+		if (replaySched.entry[i].programmed && (replaySched.entry[i].job.dev == dev))
+		{
+			job = &replaySched.entry[i].job;
+			break;
+		}
+	}
+
+	if ((job == NULL) ||
+		(chip->startWord != AD5932_DevFrequencyToWord(dev, job->params.startF)) ||
+		(chip->deltaWord != AD5932_DevFrequencyToWord(dev, job->params.deltaF)) ||
+		(chip->increment != job->params.increment) || (chip->intervall != job->params.intervall) ||
+		(chip->incrementBase != job->params.incrementBase) || (chip->sweepType != job->params.sweepType))
+	{
+		replayMismatch++;
+		printf("mismatch channel %u at %llu us\n", dev->chip, (unsigned long long)(replayNs / 1000));
+	}
+}
+
+// ....................................................................................................................
+// @brief:      Every channel with a programmed job has to be owned by the scheduler until its trigger
+// ....................................................................................................................
+static void Replay_CheckOwners(void)
+{
+	u08 i;
+
+	for (i = 0; i < replaySched.count; i++)
+	{
+		if (replaySched.entry[i].programmed && (replaySched.entry[i].job.dev->owner != &replaySched))
+		{
+			replayUnowned++;
+			printf("unowned channel %u with programmed id %lu at %llu us\n", replaySched.entry[i].job.dev->chip,
+					(unsigned long)replaySched.entry[i].job.id, (unsigned long long)(replayNs / 1000));
+		}
+	}
+}
+
+// ....................................................................................................................
+// @brief:      Deadline miss report of the scheduler
+// ....................................................................................................................
+static void Replay_Miss(const AD5932Job_t* job, u32 lateness, s32 result)
+{
+	if (result != 0)
+		replayFailed++;
+	printf("miss id %lu channel %u lateness %lu us result %ld\n", (unsigned long)job->id, job->dev->chip,
+			(unsigned long)lateness, (long)result);
+}
+
+// ....................................................................................................................
+// @brief:      Monotonic time in s
+// ....................................................................................................................
+static double Replay_Now(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (double)t.tv_sec + (double)t.tv_nsec * 1e-9;
+}
+
+// ....................................................................................................................
+// @brief:      Replacements of the functions the driver calls
+// ....................................................................................................................
+void delay_us(u32 us)
+{
+	replayNs += (u64)us * 1000;
+}
+
+void SSP_ConfigStructInit(SSP_CFG_Type* config)
+{
+	memset(config, 0, sizeof(*config));
+}
+
+void SSP_Init(LPC_SSP_TypeDef* SSPx, SSP_CFG_Type* config)
+{
+	(void)SSPx;
+	(void)config;
+}
+
+void SSP_Cmd(LPC_SSP_TypeDef* SSPx, FunctionalState state)
+{
+	(void)SSPx;
+	(void)state;
+}
+
+s32 SSP_GetTransferStatus(LPC_SSP_TypeDef* SSPx)
+{
+	(void)SSPx;
+	return SSP_STATUS_CLEAR;
+}
+
+//same arguments as the driver call: port, rx buffer, tx buffer, callback, word count, transfer type
+s32 SSP_Transfer(LPC_SSP_TypeDef* SSPx, void* rxBuffer, void* txBuffer, void* callback, u32 length, u32 type)
+{
+	const u16* words = (const u16*)txBuffer;
+	u32 i, c;
+
+	(void)SSPx;
+	(void)rxBuffer;
+	(void)callback;
+	(void)type;
+	for (i = 0; i < length; i++)
+	{
+		for (c = 0; c < REPLAY_CHANNELS; c++)
+			if (chipSelected[c])
+				AD5932_DecodeCommand(words[i], &chipSweep[c], &chipControl[c]);
+		replayNs += replayWordNs;
+	}
+	return length;
+}
+
+// ....................................................................................................................
+// @brief:      Parses one line of the trace
+// @return:     1 if a job was read, 0 if the line is empty, -1 if it is wrong
+// ....................................................................................................................
+static s32 Replay_ParseLine(char* line, ReplayJob_t* r)
+{
+	char* comment = strchr(line, '#');
+	char* token;
+	unsigned long value[6];
+	u32 i, channel;
+
+	if (comment != NULL)
+		*comment = '\0';
+
+	token = strtok(line, " \t\r\n");
+	if (token == NULL)
+		return 0;
+	r->submit = strtoull(token, NULL, 0);
+	for (i = 0; i < 6; i++)
+	{
+		token = strtok(NULL, " \t\r\n");
+		if (token == NULL)
+			return -1;
+		value[i] = strtoul(token, NULL, 0);
+	}
+	channel = value[1];
+	if (channel >= REPLAY_CHANNELS)
+		return -1;
+
+	memset(&r->job, 0, sizeof(r->job));
+	r->job.deadline = (u32)value[0];
+	r->job.dev = &replayDev[channel];
+	r->job.params.startF = value[2];
+	r->job.params.deltaF = value[3];
+	r->job.params.increment = (u16)value[4];
+	r->job.params.intervall = (u16)value[5];
+	r->job.params.incrementBase = MCLK_INP_BASED;
+	r->job.params.sweepType = INCREMENTAL_SWEEP;
+	r->job.waveType = SINE_OUT;
+	r->job.msbOut = MSBOUT_DISABLE;
+	r->job.syncSel = SYNCSEL_END;
+	r->job.syncOut = SYNCOUT_DISABLE;
+
+	while ((token = strtok(NULL, " \t\r\n")) != NULL)
+	{
+		if (!strcmp(token, "wave"))
+			r->job.params.incrementBase = WAVE_OUT_BASED;
+		else if (!strcmp(token, "dec"))
+			r->job.params.sweepType = DECREMENTAL_SWEEP;
+		else
+			return -1;
+	}
+	return 1;
+}
+
+// ....................................................................................................................
+// @brief:      Main
+// ....................................................................................................................
+int main(int argc, char* argv[])
+{
+	char line[256];
+	FILE* in;
+	u32 mclk, sclk, tolerance, period, count = 0, next = 0, lineNo = 0, rejected = 0, predicted = 0, c;
+	u64 first = 0;
+	double start, wall;
+	s32 ret;
+
+	if (argc != 6)
+	{
+		fprintf(stderr, "usage: %s <MCLK Hz> <SCLK Hz> <tolerance us> <task period us> <trace.txt>\n", argv[0]);
+		return 1;
+	}
+	mclk = strtoul(argv[1], NULL, 0);
+	sclk = strtoul(argv[2], NULL, 0);
+	tolerance = strtoul(argv[3], NULL, 0);
+	period = strtoul(argv[4], NULL, 0);
+	if ((mclk == 0) || (sclk == 0) || (period == 0))
+	{
+		fprintf(stderr, "MCLK, SCLK and the task period must not be 0\n");
+		return 1;
+	}
+
+	replayJobs = malloc(REPLAY_MAX_JOBS * sizeof(ReplayJob_t));
+	in = fopen(argv[5], "r");
+	if ((replayJobs == NULL) || (in == NULL))
+	{
+		perror(argv[5]);
+		return 1;
+	}
+	while (fgets(line, sizeof(line), in) != NULL)
+	{
+		lineNo++;
+		if (count == REPLAY_MAX_JOBS)
+		{
+			fprintf(stderr, "%s: too many jobs\n", argv[5]);
+			return 1;
+		}
+		ret = Replay_ParseLine(line, &replayJobs[count]);
+		if ((ret < 0) || ((ret > 0) && (count > 0) && (replayJobs[count].submit < replayJobs[count - 1].submit)))
+		{
+			fprintf(stderr, "%s:%lu: wrong job line (or not in submit order)\n", argv[5], (unsigned long)lineNo);
+			return 1;
+		}
+		if (ret > 0)
+			replayJobs[count++].job.id = lineNo;
+	}
+	fclose(in);
+	if (count == 0)
+	{
+		fprintf(stderr, "%s: no jobs\n", argv[5]);
+		return 1;
+	}
+
+	replayWordNs = (16ULL * 1000000000 + sclk - 1) / sclk + AD5932_SCHED_WORD_OVERHEAD * 1000ULL;
+	for (c = 0; c < REPLAY_CHANNELS; c++)
+		AD5932_DevInit(&replayDev[c], &replaySSP, Replay_ChipSelect, (u08)c, mclk);
+	AD5932_SchedInit(&replaySched, Replay_TimeBase, sclk, tolerance, Replay_Trigger, Replay_Miss);
+
+	first = replayJobs[0].submit;
+	replayNs = first * 1000;
+	start = Replay_Now();
+	while ((next < count) || (replaySched.count != 0))
+	{
+		//nothing queued: skip to the next submit
+		if ((replaySched.count == 0) && (replayNs < replayJobs[next].submit * 1000))
+			replayNs = replayJobs[next].submit * 1000;
+
+		while ((next < count) && (replayJobs[next].submit * 1000 <= replayNs))
+		{
+			ret = AD5932_SchedSubmit(&replaySched, &replayJobs[next].job);
+			if (ret == AD5932_PARAM_ERROR)
+			{
+				rejected++;
+				printf("rejected id %lu: queue full\n", (unsigned long)replayJobs[next].job.id);
+			}
+			else if (ret != 0)
+				predicted++;
+			next++;
+		}
+
+		AD5932_SchedTask(&replaySched);
+		Replay_CheckOwners();
+		replayNs += (u64)period * 1000;
+	}
+	wall = Replay_Now() - start;
+
+	printf("%lu jobs over %.6f s virtual in %.6f s (%.0fx real time)\n", (unsigned long)count,
+			(replayNs / 1000 - first) * 1e-6, wall, (wall > 0.0) ? (replayNs / 1000 - first) * 1e-6 / wall : 0.0);
+	printf("triggered %lu, late %lu, failed %lu, rejected %lu, predicted late at submit %lu, max lateness %lu us\n",
+			(unsigned long)replaySched.done, (unsigned long)(replaySched.missed - replayFailed), (unsigned long)replayFailed,
+			(unsigned long)rejected, (unsigned long)predicted, (unsigned long)replaySched.maxLateness);
+	printf("%lu triggers with a wrong chip program, %lu checks with a programmed channel left free\n", (unsigned long)replayMismatch,
+			(unsigned long)replayUnowned);
+
+	free(replayJobs);
+	return ((replayMismatch != 0) || (replayUnowned != 0) || (replaySched.done + replayFailed + rejected != count));
+}
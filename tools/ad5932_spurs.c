@@ -0,0 +1,173 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_spurs.c
+// @brief:      Host tool: spur prediction of the AD5932 output over a band, many frequencies analyzed in parallel
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+// --------------------------------------------------------------------------------------------------------------------
+// Notes
+// --------------------------------------------------------------------------------------------------------------------
+
+//Build it on the host with the same defs.h / main.h / config.h (USE_AD5932 = 1) as the firmware, no MCU_FAMILY:
+//	cc -O2 -I. -I<defs.h dir> tools/ad5932_spurs.c ad5932_spur.c ad5932_sim.c -lm -lpthread -o ad5932_spurs
+//
+//Usage:
+//	ad5932_spurs <MCLK Hz> <sine|triangle> <log2 FFT size> <threads> <from Hz> <to Hz> <step Hz>
+//Runs AD5932_SpurAnalyze() for every frequency of the band (phase truncation, 10 bit DAC, Blackman-Harris windowed
+//FFT) and prints one CSV line per frequency, in frequency order:
+//	frequency, actual frequency, SFDR dB, THD dB, then frequency / dBc pairs of the largest spurs
+//and a summary of the worst SFDR and THD to stderr. Run it with both wave types and the MCLK candidates to compare
+//them for a band. The frequencies are handed to the threads one by one, each thread has its own FFT buffer.
+
+// --------------------------------------------------------------------------------------------------------------------
+// Includes
+// --------------------------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "ad5932_spur.h"
+#include "ad5932_sim.h"
+
+// --------------------------------------------------------------------------------------------------------------------
+// Defines
+// --------------------------------------------------------------------------------------------------------------------
+
+#define SPURS_THREADS		64
+
+// --------------------------------------------------------------------------------------------------------------------
+// Variables
+// --------------------------------------------------------------------------------------------------------------------
+
+static u32 spursMCLK;
+static RegBits_t spursWave;
+static u16 spursLog2;
+static u32 spursFrom;
+static u32 spursStep;
+static u32 spursCount;
+static u32 spursNext;				//next frequency index to hand out
+static pthread_mutex_t spursLock = PTHREAD_MUTEX_INITIALIZER;
+static AD5932SpurResult_t* spursResult;
+static s32* spursError;
+
+// --------------------------------------------------------------------------------------------------------------------
+// Functions
+// --------------------------------------------------------------------------------------------------------------------
+
+// ....................................................................................................................
+// @brief:      Thread body: analyzes frequencies until the band is done
+// ....................................................................................................................
+static void* Spurs_Worker(void* arg)
+{
+	float* work;
+	u32 index;
+
+	(void)arg;
+	work = malloc(sizeof(float) * 2 * ((size_t)1 << spursLog2));
+	if (work == NULL)
+		return NULL;
+
+	for (;;)
+	{
+		pthread_mutex_lock(&spursLock);
+		index = spursNext;
+		if (spursNext < spursCount)
+			spursNext++;
+		pthread_mutex_unlock(&spursLock);
+		if (index >= spursCount)
+			break;
+
+		spursError[index] = AD5932_SpurAnalyze(spursFrom + index * spursStep, spursMCLK, spursWave, spursLog2, work, &spursResult[index]);
+	}
+	free(work);
+	return NULL;
+}
+
+// ....................................................................................................................
+// @brief:      Main
+// ....................................................................................................................
+int main(int argc, char* argv[])
+{
+	static pthread_t thread[SPURS_THREADS];
+	static bool started[SPURS_THREADS];
+	const AD5932SpurResult_t* r;
+	u32 threads, to, i, j, worstSFDR = 0, worstTHD = 0, done = 0;
+
+	if (argc != 8)
+	{
+		fprintf(stderr, "usage: %s <MCLK Hz> <sine|triangle> <log2 FFT size> <threads> <from Hz> <to Hz> <step Hz>\n", argv[0]);
+		return 1;
+	}
+	spursMCLK = strtoul(argv[1], NULL, 0);
+	spursWave = (strcmp(argv[2], "triangle") == 0) ? TRIANGLE_OUT : SINE_OUT;
+	spursLog2 = (u16)strtoul(argv[3], NULL, 0);
+	threads = strtoul(argv[4], NULL, 0);
+	spursFrom = strtoul(argv[5], NULL, 0);
+	to = strtoul(argv[6], NULL, 0);
+	spursStep = strtoul(argv[7], NULL, 0);
+	if ((spursMCLK == 0) || (spursLog2 < AD5932_SPUR_MIN_LOG2) || (spursLog2 > AD5932_SPUR_MAX_LOG2) || (to < spursFrom))
+	{
+		fprintf(stderr, "MCLK must not be 0, log2 FFT size must be %u..%u, from <= to\n", AD5932_SPUR_MIN_LOG2, AD5932_SPUR_MAX_LOG2);
+		return 1;
+	}
+	if (threads == 0)
+		threads = 1;
+	if (threads > SPURS_THREADS)
+		threads = SPURS_THREADS;
+	spursCount = (spursStep == 0) ? 1 : (to - spursFrom) / spursStep + 1;
+
+	spursResult = calloc(spursCount, sizeof(AD5932SpurResult_t));
+	spursError = calloc(spursCount, sizeof(s32));
+	if ((spursResult == NULL) || (spursError == NULL))
+	{
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	for (i = 0; i < spursCount; i++)
+		spursError[i] = AD5932_PORT_BUSY;		//not analyzed (a worker ran out of memory)
+
+	AD5932_SimInit();		//the sine ROM, before the threads share it
+	for (i = 0; i < threads; i++)
+		started[i] = (pthread_create(&thread[i], NULL, Spurs_Worker, NULL) == 0);
+	Spurs_Worker(NULL);		//the main thread works too, and finishes the band if no thread could start
+	for (i = 0; i < threads; i++)
+		if (started[i])
+			pthread_join(thread[i], NULL);
+
+	printf("frequency,actual,sfdr_db,thd_db");
+	for (j = 0; j < AD5932_SPUR_COUNT; j++)
+		printf(",spur%lu_hz,spur%lu_dbc", (unsigned long)j + 1, (unsigned long)j + 1);
+	printf("\n");
+	for (i = 0; i < spursCount; i++)
+	{
+		r = &spursResult[i];
+		if (spursError[i] != 0)
+		{
+			fprintf(stderr, "%lu Hz: not analyzed (%ld)\n", (unsigned long)(spursFrom + i * spursStep), (long)spursError[i]);
+			continue;
+		}
+		printf("%lu,%.3f,%.2f,%.2f", (unsigned long)r->frequency, r->actual, r->sfdr, r->thd);
+		for (j = 0; j < r->spurCount; j++)
+			printf(",%lu,%.2f", (unsigned long)r->spur[j].frequency, r->spur[j].level);
+		printf("\n");
+
+		if ((done == 0) || (r->sfdr < spursResult[worstSFDR].sfdr))
+			worstSFDR = i;
+		if ((done == 0) || (r->thd > spursResult[worstTHD].thd))
+			worstTHD = i;
+		done++;
+	}
+	if (done != 0)
+		fprintf(stderr, "%lu frequencies, worst SFDR %.2f dB at %lu Hz, worst THD %.2f dB at %lu Hz\n", (unsigned long)done,
+				spursResult[worstSFDR].sfdr, (unsigned long)spursResult[worstSFDR].frequency, spursResult[worstTHD].thd,
+				(unsigned long)spursResult[worstTHD].frequency);
+
+	free(spursResult);
+	free(spursError);
+	return (done != spursCount);
+}
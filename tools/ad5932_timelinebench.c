@@ -0,0 +1,182 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_timelinebench.c
+// @brief:      Host tool: speed and accuracy benchmark of the bulk step timeline of WAVE_OUT_BASED sweeps
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+// --------------------------------------------------------------------------------------------------------------------
+// Notes
+// --------------------------------------------------------------------------------------------------------------------
+
+//Build it on the host with the same defs.h / main.h / config.h (USE_AD5932 = 1) as the firmware, no MCU_FAMILY:
+//	cc -O2 -I. -I<defs.h dir> tools/ad5932_timelinebench.c ad5932_scan.c -lm -o ad5932_timelinebench
+//
+//Usage:
+//	ad5932_timelinebench <MCLK Hz> <start Hz> <delta Hz> <increments> <interval> <inc|dec> <seconds>
+//Fills the full WAVE_OUT_BASED timeline (steps 0..NINCR + 1) with AD5932_SweepTimeline() over and over for <seconds>
+//on one core, and does the same with one AD5932_StepStartTime() closed form call per step for comparison. It prints
+//the time per step of both and the ratio of the sweep duration to the time of one full timeline.
+//Every entry is checked against a long double sum of the step periods, TINT * 2^24 / (W(k) * MCLK), taken word by
+//word (1 ns limit), and the last one against AD5932_SweepDuration() (1 ns, the closed form rounds separately).
+//The exit code is 0 only if every entry is right and a full timeline takes under 10% of the sweep it describes, so a
+//scheduler can always have it before the sweep ends.
+
+// --------------------------------------------------------------------------------------------------------------------
+// Includes
+// --------------------------------------------------------------------------------------------------------------------
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+#include "ad5932_scan.h"
+
+// --------------------------------------------------------------------------------------------------------------------
+// Defines
+// --------------------------------------------------------------------------------------------------------------------
+
+#define BENCH_STEPS			(4095 + 2)		//steps 0..NINCR + 1 of the longest sweep
+#define BENCH_MARGIN		10.0			//the sweep has to last this many times longer than its timeline
+
+// --------------------------------------------------------------------------------------------------------------------
+// Variables
+// --------------------------------------------------------------------------------------------------------------------
+
+static AD5932Sweep_t benchSweep;
+static volatile u64 benchSink;			//keeps the closed form loop from being optimized out
+
+// --------------------------------------------------------------------------------------------------------------------
+// Functions
+// --------------------------------------------------------------------------------------------------------------------
+
+// ....................................................................................................................
+// @brief:      Live chip state of ad5932.c, not used by the bench (AD5932_CurrentStep() is never called)
+// ....................................................................................................................
+const AD5932Sweep_t* AD5932_GetSweep(void)
+{
+	return &benchSweep;
+}
+
+u32 AD5932_GetTriggerTime(void)
+{
+	return 0;
+}
+
+// ....................................................................................................................
+// @brief:      Monotonic time in s
+// ....................................................................................................................
+static double Bench_Now(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (double)t.tv_sec + (double)t.tv_nsec * 1e-9;
+}
+
+// ....................................................................................................................
+// @brief:      Converts a frequency to a tuning word
+// ....................................................................................................................
+static u32 Bench_Word(unsigned long frequency, unsigned long mclk)
+{
+	return (u32)(((((unsigned long long)frequency << 24) + mclk / 2) / mclk) & 0x00FFFFFF);
+}
+
+// ....................................................................................................................
+// @brief:      Main
+// ....................................................................................................................
+int main(int argc, char* argv[])
+{
+	static u64 times[BENCH_STEPS];
+	long double reference = 0.0L, error, worst = 0.0L;
+	unsigned long long rounds;
+	unsigned long k, count, bad = 0;
+	unsigned long long word;
+	double seconds, start, elapsed, timeline, closed, duration;
+
+	if (argc != 8)
+	{
+		fprintf(stderr, "usage: %s <MCLK Hz> <start Hz> <delta Hz> <increments> <interval> <inc|dec> <seconds>\n", argv[0]);
+		return 1;
+	}
+	memset(&benchSweep, 0, sizeof(benchSweep));
+	benchSweep.mclk = strtoul(argv[1], NULL, 0);
+	if (benchSweep.mclk == 0)
+	{
+		fprintf(stderr, "MCLK must not be 0\n");
+		return 1;
+	}
+	benchSweep.startWord = Bench_Word(strtoul(argv[2], NULL, 0), benchSweep.mclk);
+	benchSweep.deltaWord = Bench_Word(strtoul(argv[3], NULL, 0), benchSweep.mclk);
+	benchSweep.increment = (u16)strtoul(argv[4], NULL, 0);
+	benchSweep.intervall = (u16)strtoul(argv[5], NULL, 0);
+	benchSweep.incrementBase = WAVE_OUT_BASED;
+	benchSweep.sweepType = (strcmp(argv[6], "dec") == 0) ? DECREMENTAL_SWEEP : INCREMENTAL_SWEEP;
+	seconds = atof(argv[7]);
+	word = (unsigned long long)benchSweep.increment * benchSweep.deltaWord;
+	if ((benchSweep.increment < 2) || (benchSweep.increment > 4095) || (benchSweep.intervall < 2) || (benchSweep.intervall > 2047) ||
+		(benchSweep.startWord == 0) || ((benchSweep.sweepType == DECREMENTAL_SWEEP) ? (word >= benchSweep.startWord) :
+		(benchSweep.startWord + word >= AD5932_ACCU_RESOLUTION / 2)))
+	{
+		fprintf(stderr, "increments 2..4095, interval 2..2047, the sweep must stay in 0 < f < MCLK / 2\n");
+		return 1;
+	}
+
+	//accuracy: every entry against the step periods summed word by word
+	count = AD5932_SweepTimeline(&benchSweep, 0, BENCH_STEPS, times);
+	for (k = 0; k < count; k++)
+	{
+		error = (long double)times[k] - reference;
+		if (error < 0.0L)
+			error = -error;
+		if (error > worst)
+			worst = error;
+		if (error > 1.0L)
+			bad++;
+
+		if (benchSweep.sweepType == DECREMENTAL_SWEEP)
+			word = (benchSweep.startWord - (unsigned long long)k * benchSweep.deltaWord) & 0x00FFFFFF;
+		else
+			word = (benchSweep.startWord + (unsigned long long)k * benchSweep.deltaWord) & 0x00FFFFFF;
+		reference += (long double)benchSweep.intervall * AD5932_ACCU_RESOLUTION * 1e9L / ((long double)word * benchSweep.mclk);
+	}
+	duration = (double)AD5932_SweepDuration(&benchSweep);
+	if ((count == 0) || (fabs((double)times[count - 1] - duration) > 1.0))
+	{
+		fprintf(stderr, "the timeline end differs from AD5932_SweepDuration()\n");
+		bad++;
+	}
+
+	//speed: bulk timeline, then the closed form step by step
+	rounds = 0;
+	start = Bench_Now();
+	do
+	{
+		AD5932_SweepTimeline(&benchSweep, 0, BENCH_STEPS, times);
+		rounds++;
+		elapsed = Bench_Now() - start;
+	} while (elapsed < seconds);
+	timeline = elapsed / rounds;
+
+	rounds = 0;
+	start = Bench_Now();
+	do
+	{
+		for (k = 0; k < count; k++)
+			benchSink += AD5932_StepStartTime(&benchSweep, (u32)k);
+		rounds++;
+		elapsed = Bench_Now() - start;
+	} while (elapsed < seconds);
+	closed = elapsed / rounds;
+
+	printf("%lu entries: timeline %.2f ns/step, closed form %.2f ns/step (%.1fx)\n", count, timeline * 1e9 / count,
+			closed * 1e9 / count, closed / timeline);
+	printf("sweep %.6f s, one full timeline %.3f us, %.0fx margin\n", duration * 1e-9, timeline * 1e6, duration * 1e-9 / timeline);
+	printf("worst error %.3Lf ns, %lu entries over 1 ns\n", worst, bad);
+	return ((bad != 0) || (duration * 1e-9 < timeline * BENCH_MARGIN));
+}
@@ -0,0 +1,147 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_trace2json.c
+// @brief:      Host tool: converts an AD5932 trace dump (see ad5932_trace.h) to a Chrome / Perfetto JSON trace
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+// --------------------------------------------------------------------------------------------------------------------
+// Notes
+// --------------------------------------------------------------------------------------------------------------------
+
+//Build it on the host with the same defs.h as the firmware:
+//	cc -I. -I<defs.h dir> tools/ad5932_trace2json.c -o ad5932_trace2json
+//
+//Usage:
+//	ad5932_trace2json <trace.bin> <trace.json>
+//The dump is what AD5932_TraceDump() wrote. Open the JSON in chrome://tracing or ui.perfetto.dev: every event type
+//is a track of its own (sweep call, sweep validate, bus wait, SPI words, CTRL, SYNCOUT), SPI words show the command
+//word, the sweep call its result. The bus waits of the arbiter clients may overlap, so they are async events with the
+//client as id: every client waits on a track of its own. The 32 bit trace clock may wrap during the trace, it is
+//unwrapped event by event.
+
+// --------------------------------------------------------------------------------------------------------------------
+// Includes
+// --------------------------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ad5932_trace.h"
+
+// --------------------------------------------------------------------------------------------------------------------
+// Variables
+// --------------------------------------------------------------------------------------------------------------------
+
+static const char* const traceName[AD5932_TR_TYPES] = { "AD5932_SweepGenerator", "sweep validate", "bus wait", "SPI word", "CTRL", "SYNCOUT" };
+
+// --------------------------------------------------------------------------------------------------------------------
+// Functions
+// --------------------------------------------------------------------------------------------------------------------
+
+// ....................................................................................................................
+// @brief:      Writes the arguments of an event
+// @param[in]:  Output, event
+// ....................................................................................................................
+static void Trace_Args(FILE* out, const AD5932TraceEvent_t* e)
+{
+	switch (e->type)
+	{
+		case AD5932_TR_SWEEP:
+			if (e->phase == AD5932_TR_END)
+				fprintf(out, ",\"args\":{\"result\":%d}", (int)(int16_t)e->arg);
+			break;
+		case AD5932_TR_SPI_WORD:
+			fprintf(out, ",\"args\":{\"word\":\"0x%04X\"}", (unsigned int)e->arg);
+			break;
+		case AD5932_TR_BUS_WAIT:
+			fprintf(out, ",\"args\":{\"%s\":%u}", (e->phase == AD5932_TR_INSTANT) ? "word" : "client", (unsigned int)e->arg);
+			break;
+		case AD5932_TR_SYNCOUT:
+			fprintf(out, ",\"args\":{\"step\":%u}", (unsigned int)e->arg);
+			break;
+		default:
+			break;
+	}
+}
+
+// ....................................................................................................................
+// @brief:      Main
+// ....................................................................................................................
+int main(int argc, char* argv[])
+{
+	AD5932TraceHeader_t header;
+	AD5932TraceEvent_t e;
+	FILE* in;
+	FILE* out;
+	u64 ticks = 0;
+	uint32_t last = 0;
+	uint32_t i;
+	bool async;
+
+	if (argc != 3)
+	{
+		fprintf(stderr, "usage: %s <trace.bin> <trace.json>\n", argv[0]);
+		return 1;
+	}
+
+	in = fopen(argv[1], "rb");
+	if (in == NULL)
+	{
+		perror(argv[1]);
+		return 1;
+	}
+	if ((fread(&header, sizeof(header), 1, in) != 1) || (header.magic != AD5932_TRACE_MAGIC) ||
+		(header.version != AD5932_TRACE_VERSION) || (header.eventSize != sizeof(AD5932TraceEvent_t)) || (header.ticksPerUs == 0))
+	{
+		fprintf(stderr, "%s: not an AD5932 trace dump\n", argv[1]);
+		fclose(in);
+		return 1;
+	}
+
+	out = fopen(argv[2], "w");
+	if (out == NULL)
+	{
+		perror(argv[2]);
+		fclose(in);
+		return 1;
+	}
+
+	fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+	fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"AD5932\"}}");
+	for (i = 0; i < AD5932_TR_TYPES; i++)
+		fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,\"args\":{\"name\":\"%s\"}}", (unsigned long)i + 1, traceName[i]);
+
+	for (i = 0; i < header.count; i++)
+	{
+		if (fread(&e, sizeof(e), 1, in) != 1)
+		{
+			fprintf(stderr, "%s: truncated after %lu events\n", argv[1], (unsigned long)i);
+			break;
+		}
+		if (e.type >= AD5932_TR_TYPES)
+			continue;
+
+		ticks += (i == 0) ? 0 : (uint32_t)(e.time - last);
+		last = e.time;
+
+		async = (e.type == AD5932_TR_BUS_WAIT) && (e.phase != AD5932_TR_INSTANT);
+		fprintf(out, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%u", traceName[e.type],
+				async ? ((e.phase == AD5932_TR_BEGIN) ? 'b' : 'e') : e.phase, (double)ticks / header.ticksPerUs, (unsigned int)e.type + 1);
+		if (async)
+			fprintf(out, ",\"cat\":\"bus\",\"id\":%u", (unsigned int)e.arg);
+		if (e.phase == AD5932_TR_INSTANT)
+			fprintf(out, ",\"s\":\"t\"");
+		Trace_Args(out, &e);
+		fprintf(out, "}");
+	}
+	fprintf(out, "\n],\"otherData\":{\"events\":%lu,\"dropped\":%lu}}\n", (unsigned long)header.count, (unsigned long)header.dropped);
+
+	if (header.dropped != 0)
+		fprintf(stderr, "%lu events were dropped on the target, the trace is cut\n", (unsigned long)header.dropped);
+	fclose(in);
+	fclose(out);
+	return 0;
+}
@@ -0,0 +1,367 @@
+
+// ********************************************************************************************************************
+// @file        ad5932_vcdsim.c
+// @brief:      Host tool: runs the unmodified AD5932 driver against a chip model and streams the signals to a VCD file
+// @version     1.0
+// @date        2026.10.16
+// @author      Tamas Kovacs, Tamas Besenyi
+// ********************************************************************************************************************
+
+// --------------------------------------------------------------------------------------------------------------------
+// Notes
+// --------------------------------------------------------------------------------------------------------------------
+
+//Build it on the host with the firmware headers (defs.h, main.h, config.h with USE_AD5932 = 1, the LPC17xx driver
+//headers), the pins mocked and the PWM stepping left out, and link the driver itself:
+//	cc -I. -I<firmware include dirs> -DAD5932_PIN_MOCK -DAD5932_USE_PWM_CTRL=0 tools/ad5932_vcdsim.c ad5932.c ad5932_vcd.c -o ad5932_vcdsim
+//
+//Usage:
+//	ad5932_vcdsim <MCLK Hz> <SCLK Hz> <start Hz> <delta Hz> <increments> <interval> <mclk|wave> <end us> <out.vcd>
+//Programs an incremental sweep with AD5932_SweepGenerator() (automatic trigger, MSBOUT on, SYNCOUT at every step) and
+//dumps SCLK, SDATA, FSYNC, CTRL, INTERRUPT, STANDBY, SYNCOUT and MSBOUT until <end us>. Open the file with GTKWave.
+//
+//The tool replaces the functions the driver calls: the SSP driver (each word is drawn on SCLK / SDATA at the SCLK set
+//by AD5932_ConfigSPI() and decoded into the chip model), delay_us() (advances the virtual time) and the pins
+//(ad5932PinMockHook). The chip model runs the 24 bit phase accumulator in MCLK cycles, so MSBOUT is the accumulator
+//MSB edge by edge, and it steps the frequency after TINT MCLK periods / TINT output cycles or at CTRL rising edges
+//(external trigger). SYNCOUT is a 4 MCLK wide pulse per step, or goes high at the end of the scan. A control register
+//write resets the state machines as the INTERRUPT pin does: the output stops until the next CTRL rising edge.
+//Events are written as they happen, through the buffer of ad5932_vcd.c, so the file grows at disk speed.
+
+// --------------------------------------------------------------------------------------------------------------------
+// Includes
+// --------------------------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ad5932.h"
+#include "ad5932_vcd.h"
+
+// --------------------------------------------------------------------------------------------------------------------
+// Defines
+// --------------------------------------------------------------------------------------------------------------------
+
+#define SIM_HALF			0x800000ULL		//accumulator MSB
+#define SIM_FULL			0x1000000ULL	//accumulator range
+#define SIM_NEVER			0xFFFFFFFFFFFFFFFFULL
+#define SIM_SYNC_PULSE		4				//MCLK periods of a SYNCOUT pulse
+
+// --------------------------------------------------------------------------------------------------------------------
+// Variables
+// --------------------------------------------------------------------------------------------------------------------
+
+static AD5932Vcd_t simVcd;
+static LPC_SSP_TypeDef simSSP;
+static u64 simNs;					//virtual time of the driver
+static u32 simSCLK = 1000000;
+static u32 simMCLK;
+static u08 simPins;					//last seen ad5932PinMock
+
+//chip model
+static AD5932Sweep_t chipSweep;		//registers, as decoded from the SPI words
+static u16 chipControl;
+static bool chipRunning;			//DDS output on
+static bool chipScanning;			//sweep in progress
+static u64 chipCycle;				//MCLK cycles done by the model
+static u32 chipAcc;					//phase accumulator, 24 bit
+static u32 chipWord;				//current tuning word
+static u32 chipStep;				//current step
+static u64 chipStepLeft;			//MCLK periods left of the step (MCLK based interval)
+static u32 chipWraps;				//output cycles of the step (output based interval)
+static u64 chipSyncLow;				//cycle of the SYNCOUT pulse end, SIM_NEVER if none
+
+// --------------------------------------------------------------------------------------------------------------------
+// Functions
+// --------------------------------------------------------------------------------------------------------------------
+
+// ....................................................................................................................
+// @brief:      Writes the VCD text to the file
+// @param[in]:  FILE*, text, length
+// @return:     false if the write failed
+// ....................................................................................................................
+static bool Sim_Write(void* context, const char* data, u32 length)
+{
+	return fwrite(data, 1, length, (FILE*)context) == length;
+}
+
+// ....................................................................................................................
+// @brief:      Converts between MCLK cycles and ns without overflow
+// ....................................................................................................................
+static u64 Sim_CycleToNs(u64 cycle)
+{
+	return (cycle / simMCLK) * 1000000000ULL + ((cycle % simMCLK) * 1000000000ULL) / simMCLK;
+}
+
+static u64 Sim_NsToCycle(u64 ns)
+{
+	return (ns / 1000000000ULL) * simMCLK + ((ns % 1000000000ULL) * simMCLK) / 1000000000ULL;
+}
+
+// ....................................................................................................................
+// @brief:      Tuning word of the current step
+// ....................................................................................................................
+static u32 Chip_StepWord(void)
+{
+	u32 offset = chipSweep.deltaWord * chipStep;
+
+	if (chipSweep.sweepType == DECREMENTAL_SWEEP)
+		return (chipSweep.startWord - offset) & (SIM_FULL - 1);
+	return (chipSweep.startWord + offset) & (SIM_FULL - 1);
+}
+
+// ....................................................................................................................
+// @brief:      Starts the next step, or ends the scan after the last one
+// ....................................................................................................................
+static void Chip_NextStep(void)
+{
+	u64 now = Sim_CycleToNs(chipCycle);
+
+	chipStepLeft = chipSweep.intervall;
+	chipWraps = 0;
+	if (chipStep < chipSweep.increment)
+	{
+		chipStep++;
+		chipWord = Chip_StepWord();
+		if ((chipControl & (1 << 2)) && !(chipControl & (1 << 3)))		//SYNCOUT_EN, SYNCSEL_SUBSEQVENT
+		{
+			AD5932_VcdSet(&simVcd, now, AD5932_VCD_SYNCOUT, true);
+			chipSyncLow = chipCycle + SIM_SYNC_PULSE;
+		}
+		return;
+	}
+
+	chipScanning = false;
+	if ((chipControl & (1 << 2)) && (chipControl & (1 << 3)))			//SYNCOUT_EN, SYNCSEL_END
+		AD5932_VcdSet(&simVcd, now, AD5932_VCD_SYNCOUT, true);
+}
+
+// ....................................................................................................................
+// @brief:      Runs the chip model up to a time, writing the MSBOUT / SYNCOUT edges on the way
+// @param[in]:  Time in ns
+// ....................................................................................................................
+static void Chip_Advance(u64 ns)
+{
+	u64 target = Sim_NsToCycle(ns);
+	u64 toEdge, toStep, toSync, step;
+	bool wrapped;
+
+	while (chipCycle < target)
+	{
+		if (!chipRunning)
+		{
+			chipCycle = target;
+			break;
+		}
+
+		toEdge = SIM_NEVER;
+		if (chipWord != 0)
+			toEdge = (((chipAcc < SIM_HALF) ? SIM_HALF : SIM_FULL) - chipAcc + chipWord - 1) / chipWord;
+		toStep = SIM_NEVER;
+		if (chipScanning && !(chipControl & (1 << 5)) && (chipSweep.incrementBase != WAVE_OUT_BASED))
+			toStep = chipStepLeft;
+		toSync = (chipSyncLow != SIM_NEVER) ? chipSyncLow - chipCycle : SIM_NEVER;
+
+		step = target - chipCycle;
+		if (toEdge < step)
+			step = toEdge;
+		if (toStep < step)
+			step = toStep;
+		if (toSync < step)
+			step = toSync;
+
+		wrapped = (chipAcc + (u64)chipWord * step) >= SIM_FULL;
+		chipAcc = (u32)((chipAcc + (u64)chipWord * step) & (SIM_FULL - 1));
+		chipCycle += step;
+		if (toStep != SIM_NEVER)
+			chipStepLeft -= step;
+
+		if (step == toSync)
+		{
+			AD5932_VcdSet(&simVcd, Sim_CycleToNs(chipCycle), AD5932_VCD_SYNCOUT, false);
+			chipSyncLow = SIM_NEVER;
+		}
+		if (step == toEdge)
+		{
+			if (chipControl & (1 << 8))		//MSBOUT_EN
+				AD5932_VcdSet(&simVcd, Sim_CycleToNs(chipCycle), AD5932_VCD_MSBOUT, chipAcc >= SIM_HALF);
+			if (wrapped && chipScanning && !(chipControl & (1 << 5)) && (chipSweep.incrementBase == WAVE_OUT_BASED) &&
+				(++chipWraps >= chipSweep.intervall))
+				Chip_NextStep();
+		}
+		if ((step == toStep) && (chipStepLeft == 0))
+			Chip_NextStep();
+	}
+}
+
+// ....................................................................................................................
+// @brief:      Resets the state machines (INTERRUPT pin or control register write): output stopped, phase cleared
+// @param[in]:  Time in ns
+// ....................................................................................................................
+static void Chip_Reset(u64 ns)
+{
+	chipRunning = chipScanning = false;
+	chipAcc = 0;
+	AD5932_VcdSet(&simVcd, ns, AD5932_VCD_MSBOUT, false);
+}
+
+// ....................................................................................................................
+// @brief:      Pin change hook of the driver (ad5932PinMockHook)
+// ....................................................................................................................
+static void Sim_Pins(void)
+{
+	u08 pins = ad5932PinMock;
+	u08 changed = pins ^ simPins;
+
+	simPins = pins;
+	Chip_Advance(simNs);
+
+	if (changed & AD5932_PIN_FSYNC)
+		AD5932_VcdSet(&simVcd, simNs, AD5932_VCD_FSYNC, pins & AD5932_PIN_FSYNC);
+	if (changed & AD5932_PIN_STDBY)
+	{
+		AD5932_VcdSet(&simVcd, simNs, AD5932_VCD_STDBY, pins & AD5932_PIN_STDBY);
+		if (pins & AD5932_PIN_STDBY)
+			chipRunning = chipScanning = false;
+	}
+	if (changed & AD5932_PIN_INT)
+	{
+		AD5932_VcdSet(&simVcd, simNs, AD5932_VCD_INT, pins & AD5932_PIN_INT);
+		if (pins & AD5932_PIN_INT)
+			Chip_Reset(simNs);
+	}
+	if (changed & AD5932_PIN_CTRL)
+	{
+		AD5932_VcdSet(&simVcd, simNs, AD5932_VCD_CTRL, pins & AD5932_PIN_CTRL);
+		if (!(pins & AD5932_PIN_CTRL) || (pins & AD5932_PIN_STDBY))
+			return;
+		if (chipScanning && (chipControl & (1 << 5)))	//EXTERNAL_TRIGGER: CTRL steps
+		{
+			Chip_NextStep();
+			return;
+		}
+		chipRunning = chipScanning = true;
+		chipStep = 0;
+		chipWord = Chip_StepWord();
+		chipStepLeft = chipSweep.intervall;
+		chipWraps = 0;
+		AD5932_VcdSet(&simVcd, simNs, AD5932_VCD_SYNCOUT, false);
+	}
+}
+
+// ....................................................................................................................
+// @brief:      Replacements of the functions the driver calls
+// ....................................................................................................................
+void delay_us(u32 us)
+{
+	simNs += (u64)us * 1000;
+	Chip_Advance(simNs);
+}
+
+void SSP_ConfigStructInit(SSP_CFG_Type* config)
+{
+	memset(config, 0, sizeof(*config));
+}
+
+void SSP_Init(LPC_SSP_TypeDef* SSPx, SSP_CFG_Type* config)
+{
+	(void)SSPx;
+	simSCLK = config->ClockRate;
+}
+
+void SSP_Cmd(LPC_SSP_TypeDef* SSPx, FunctionalState state)
+{
+	(void)SSPx;
+	(void)state;
+}
+
+s32 SSP_GetTransferStatus(LPC_SSP_TypeDef* SSPx)
+{
+	(void)SSPx;
+	return SSP_STATUS_CLEAR;
+}
+
+//same arguments as the driver call: port, rx buffer, tx buffer, callback, word count, transfer type
+s32 SSP_Transfer(LPC_SSP_TypeDef* SSPx, void* rxBuffer, void* txBuffer, void* callback, u32 length, u32 type)
+{
+	const u16* words = (const u16*)txBuffer;
+	u32 i;
+
+	(void)SSPx;
+	(void)rxBuffer;
+	(void)callback;
+	(void)type;
+	for (i = 0; i < length; i++)
+	{
+		Chip_Advance(simNs);
+		simNs = AD5932_VcdWord(&simVcd, simNs, words[i], simSCLK);
+		AD5932_DecodeCommand(words[i], &chipSweep, &chipControl);
+		if ((words[i] & 0xF000) == AD5932_CREG)
+		{
+			//a control register write resets the state machines like INTERRUPT, the output waits for CTRL again
+			Chip_Advance(simNs);
+			Chip_Reset(simNs);
+		}
+	}
+	return length;
+}
+
+// ....................................................................................................................
+// @brief:      Main
+// ....................................................................................................................
+int main(int argc, char* argv[])
+{
+	u32 startF, deltaF, increment, intervall;
+	AD5932_IncIntervall_t base;
+	u64 endNs;
+	FILE* out;
+	s32 ret;
+
+	if (argc != 10)
+	{
+		fprintf(stderr, "usage: %s <MCLK Hz> <SCLK Hz> <start Hz> <delta Hz> <increments> <interval> <mclk|wave> <end us> <out.vcd>\n", argv[0]);
+		return 1;
+	}
+	simMCLK = strtoul(argv[1], NULL, 0);
+	startF = strtoul(argv[3], NULL, 0);
+	deltaF = strtoul(argv[4], NULL, 0);
+	increment = strtoul(argv[5], NULL, 0);
+	intervall = strtoul(argv[6], NULL, 0);
+	base = (strcmp(argv[7], "wave") == 0) ? WAVE_OUT_BASED : MCLK_INP_BASED;
+	endNs = strtoull(argv[8], NULL, 0) * 1000;
+	if (simMCLK == 0)
+	{
+		fprintf(stderr, "MCLK must not be 0\n");
+		return 1;
+	}
+
+	out = fopen(argv[9], "wb");
+	if (out == NULL)
+	{
+		perror(argv[9]);
+		return 1;
+	}
+
+	//idle levels: SCLK and FSYNC high
+	AD5932_VcdInit(&simVcd, Sim_Write, out, (1 << AD5932_VCD_SCLK) | (1 << AD5932_VCD_FSYNC));
+	simPins = AD5932_PIN_FSYNC;
+	ad5932PinMock = AD5932_PIN_FSYNC;
+	ad5932PinMockHook = Sim_Pins;
+
+	AD5932_Init(simMCLK);
+	AD5932_ConfigSPI(&simSSP, SSP_CPOL_LO, SSP_CPHA_SECOND, strtoul(argv[2], NULL, 0));
+	AD5932_SetSPI(&simSSP);
+	ret = AD5932_SweepGenerator(startF, deltaF, increment, base, intervall, (RegBits_t)INCREMENTAL_SWEEP,
+								SINE_OUT, MSBOUT_EN, AUTOMATIC_TRIGGER, SYNCSEL_SUBSEQVENT, SYNCOUT_EN);
+	if (ret != 0)
+		fprintf(stderr, "AD5932_SweepGenerator: %ld\n", (long)ret);
+
+	if (endNs > simNs)
+		simNs = endNs;
+	Chip_Advance(simNs);
+	if (!AD5932_VcdFinish(&simVcd, simNs))
+		fprintf(stderr, "write error\n");
+	fclose(out);
+	return (ret != 0);
+}